@@ -0,0 +1,228 @@
+#include "extrusion.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef HPARAMETERS
+#define HPARAMETERS
+#include "parameters.h"
+#endif
+
+/////////////////////////////////////////////
+// Microbenchmarks of the extrusion engine on synthetic chains,
+// friend of Extrusion to time its internal steps
+/////////////////////////////////////////////
+class Bench
+{
+
+public:
+    double seconds;   // time spent on each measure
+    string tmp;       // prefix of the temporary input files
+
+    Bench(double s) : seconds(s), tmp("bench.tmp") {}
+    void Header(ostream &out);
+    void Case(ostream &out, string engine, int length, int n_extr, double ctcf_density);
+
+private:
+    void WriteInputs(string engine, int length, int n_extr, double ctcf_density);
+    double Now(void);
+    long PeakRSS(void);
+};
+
+/////////////////////////////////////////////
+// Names of the columns of the CSV output
+/////////////////////////////////////////////
+void Bench::Header(ostream &out)
+{
+    out << "engine,length,extruders,ctcf_density,events,events_per_s,propensities_ns,check_propensities_ns,check_step_ns,add_remove_ns,read_state_ms,peak_rss_kb" << endl;
+}
+
+/////////////////////////////////////////////
+// Parameter, CTCF and state files of a case: n_extr extruders
+// side by side, which stay all bound (n_extr_tot = n_extr)
+/////////////////////////////////////////////
+void Bench::WriteInputs(string engine, int length, int n_extr, double ctcf_density)
+{
+    ofstream parm(tmp+".in");
+    parm << "length " << length << "\n" << "time_max 1E9\n" << "timestep 1\n";
+    parm << "k_binding 1\n" << "k_unbinding 0.001\n" << "k_step 1\n" << "k_cross_ctcf 0.1\n";
+    parm << "n_extr_tot " << n_extr << "\n" << "n_extr_max " << n_extr + 1 << "\n";
+    parm << "seed 1\n" << "engine " << engine << "\n";
+    parm << "ctcf_file " << tmp << ".ctcf\n" << "state_file " << tmp << ".state\n";
+    parm.close();
+
+    // barriers of random type at regular distance
+    ofstream ctcf(tmp+".ctcf");
+    int n_ctcf = (int)(ctcf_density * length);
+    const int types[3] = {-1, 1, 2};
+    for (int k=0; k<n_ctcf; k++) ctcf << (long)k * length / n_ctcf << " " << types[k % 3] << "\n";
+    ctcf.close();
+
+    // extruder k holds the first half of the k-th part of the chain
+    ofstream state(tmp+".state");
+    int gap = length / n_extr;
+    state << length << "\n" << n_extr << "\n" << n_extr + 1 << "\n";
+    for (int k=0; k<n_extr; k++) state << k * gap << " " << k * gap + max(1, gap / 2) << " 0 0 " << k << "\n";
+    state.close();
+}
+
+/////////////////////////////////////////////
+// Time all the measures of a case and write them as a CSV line
+/////////////////////////////////////////////
+void Bench::Case(ostream &out, string engine, int length, int n_extr, double ctcf_density)
+{
+    WriteInputs(engine, length, n_extr, ctcf_density);
+
+    string parmFile = tmp+".in";
+    char *argv[2] = {(char *) "bench", (char *) parmFile.c_str()};
+    Parameters parm(2, argv);
+    Extrusion e( parm );
+    e.CatchError( e.ReadCTCF(parm.ctcf_file) );
+
+    double t0 = Now();
+    e.CatchError( e.ReadState(parm.state_file, false) );
+    double readState = Now() - t0;
+
+    // Gillespie events, in chunks until the time is over
+    long events = 0;
+    t0 = Now();
+    do
+    {
+       for (int k=0; k<1000; k++) e.CatchError( e.Event(false) );
+       events += 1000;
+    } while (Now() - t0 < seconds);
+    double eventTime = Now() - t0;
+
+    // propensities from the counts of legs kept at each event, independent of the size
+    long calls = 0;
+    t0 = Now();
+    do
+    {
+       for (int k=0; k<10; k++) e.CalculatePropensities(false);
+       calls += 10;
+    } while (Now() - t0 < seconds);
+    double propensities = (Now() - t0) / calls;
+
+    // full recalculation of the status of all the legs, as checked in debug mode
+    calls = 0;
+    t0 = Now();
+    do
+    {
+       e.CatchError( e.CheckPropensities() );
+       calls++;
+    } while (Now() - t0 < seconds);
+    double checkPropensities = (Now() - t0) / calls;
+
+    // step checks of all the legs
+    long checks = 0;
+    volatile bool sink = false;
+    t0 = Now();
+    do
+    {
+       for (int w=0; w<e.n_extr_bound; w++)
+          for (int dir=0; dir<2; dir++)
+             sink = e.CheckStepOk(e.pool.handle[w], dir, false) ^ sink;
+       checks += 2 * e.n_extr_bound;
+    } while (Now() - t0 < seconds && checks > 0);
+    double checkStep = checks > 0 ? (Now() - t0) / checks : 0.;
+
+    // unbinding and binding again of the extruders, in turn
+    long cycles = 0;
+    t0 = Now();
+    do
+    {
+       for (int k=0; k<100 && e.n_extr_bound > 0; k++)
+       {
+          int h = e.pool.handle[cycles % e.n_extr_bound];
+          int i = e.pool.site[0][h], j = e.pool.site[1][h], index = e.pool.index[h];
+          int64_t iTimeI = e.pool.arrival[0][h], iTimeJ = e.pool.arrival[1][h];
+          e.CatchError( e.RemoveExtruder(h) );
+          e.CatchError( e.AddExtruder(i, j, iTimeI, iTimeJ, index) );
+          cycles++;
+       }
+    } while (Now() - t0 < seconds && e.n_extr_bound > 0);
+    double addRemove = cycles > 0 ? (Now() - t0) / cycles : 0.;
+
+    out << engine << "," << length << "," << n_extr << "," << ctcf_density << "," << events << ",";
+    out << events / eventTime << "," << propensities * 1E9 << "," << checkPropensities * 1E9 << "," << checkStep * 1E9 << ",";
+    out << addRemove * 1E9 << "," << readState * 1E3 << "," << PeakRSS() << endl;
+
+    remove((tmp+".in").c_str());
+    remove((tmp+".ctcf").c_str());
+    remove((tmp+".state").c_str());
+}
+
+double Bench::Now(void)
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////
+// Peak resident memory of the process so far, in kB: each case
+// runs in a process of its own, so this is the peak of the case
+/////////////////////////////////////////////
+long Bench::PeakRSS(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/////////////////////////////////////////////
+// Benchmark over a grid of chain lengths, numbers of extruders
+// and CTCF densities, for both engines; CSV on the standard output.
+// Each case runs in a child process, which starts with the small
+// memory of the driver and not with the peak of the earlier cases.
+// Usage: bench [seconds per measure] [largest chain length]
+/////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? stod(argv[1]) : 0.2;
+    int maxLength = argc > 2 ? stoi(argv[2]) : 1000000;
+
+    // the output of the engine is not part of the benchmark
+    streambuf *stdoutBuf = cout.rdbuf();
+    ostream out(stdoutBuf);
+    ostringstream mute;
+    cout.rdbuf(mute.rdbuf());
+
+    Bench bench(seconds);
+    bench.Header(out);
+
+    const string engines[2] = {"direct", "next_reaction"};
+    const double densities[3] = {0., 0.01, 0.1};
+    for (int length=1000; length<=maxLength; length*=10)
+       for (int n_extr=10; n_extr<=10000 && 4*n_extr<=length; n_extr*=10)
+          for (int d=0; d<3; d++)
+             for (int en=0; en<2; en++)
+             {
+                pid_t pid = fork();
+                if (pid < 0)
+                {
+                   cerr << "Cannot fork the case of length " << length << endl;
+                   return 1;
+                }
+                if (pid == 0)
+                {
+                   bench.Case(out, engines[en], length, n_extr, densities[d]);
+                   out.flush();
+                   _exit(0);
+                }
+                int status;
+                waitpid(pid, &status, 0);
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                {
+                   cerr << "Case of length " << length << " with " << n_extr << " extruders failed" << endl;
+                   return 1;
+                }
+             }
+
+    cout.rdbuf(stdoutBuf);
+    return 0;
+}
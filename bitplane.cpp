@@ -0,0 +1,98 @@
+#include "bitplane.h"
+
+/////////////////////////////////////////////
+// BitPlane constructor, all sites clear
+/////////////////////////////////////////////
+BitPlane::BitPlane(int length_)
+{
+   bits = nullptr;
+   Resize(length_);
+}
+
+BitPlane::~BitPlane()
+{
+   delete[] bits;
+}
+
+/////////////////////////////////////////////
+// Reallocate for length sites, all clear
+/////////////////////////////////////////////
+void BitPlane::Resize(int length_)
+{
+   delete[] bits;
+
+   length = length_;
+   n_words = (length + 2 + 63) / 64;
+   bits = new uint64_t[n_words];
+   for (int k = 0; k < n_words; k++)
+      bits[k] = 0;
+}
+
+/////////////////////////////////////////////
+// First set site after s going left (dir=0) or right (dir=1),
+// -1 or length if there is none; a word of 64 sites at a time
+/////////////////////////////////////////////
+int BitPlane::Next(int s, int dir)
+{
+   if (dir == 1)
+   {
+      unsigned u = s + 2;
+      if (u >= (unsigned)length + 1)
+         return length;
+      int k = u >> 6;
+      uint64_t word = bits[k] & (~0ULL << (u & 63));
+      while (word == 0)
+      {
+         if (++k == n_words)
+            return length;
+         word = bits[k];
+      }
+      int found = 64 * k + __builtin_ctzll(word) - 1;
+      return found < length ? found : length;
+   }
+   else
+   {
+      if (s <= 0)
+         return -1;
+      unsigned u = s; // site s-1
+      int k = u >> 6;
+      uint64_t word = bits[k] & (~0ULL >> (63 - (u & 63)));
+      while (word == 0)
+      {
+         if (--k < 0)
+            return -1;
+         word = bits[k];
+      }
+      return 64 * k + 63 - __builtin_clzll(word) - 1;
+   }
+}
+
+/////////////////////////////////////////////
+// Number of set sites
+/////////////////////////////////////////////
+long BitPlane::Count(void)
+{
+   long n = 0;
+   for (int k = 0; k < n_words; k++)
+      n += __builtin_popcountll(bits[k]);
+   return n;
+}
+
+/////////////////////////////////////////////
+// Length and words of the plane
+/////////////////////////////////////////////
+void BitPlane::Save(Checkpoint &c)
+{
+   c.Put(&length, sizeof(int));
+   c.Put(bits, n_words * sizeof(uint64_t));
+}
+
+bool BitPlane::Restore(Checkpoint &c)
+{
+   int length_;
+   if (!c.Get(&length_, sizeof(int)))
+      return false;
+
+   Resize(length_);
+   return c.Get(bits, n_words * sizeof(uint64_t));
+}
@@ -0,0 +1,35 @@
+#include <stdint.h>
+
+#ifndef BITPLANE_H
+#define BITPLANE_H
+
+#include "checkpoint.h"
+
+/////////////////////////////////////////////
+// One bit per site of the chain, 64 sites per word. The sites
+// -1 and length are kept as padding and always clear, so
+// tests at the ends of the chain need no branch.
+/////////////////////////////////////////////
+class BitPlane
+{
+
+public:
+  BitPlane(int length = 0);
+  ~BitPlane();
+
+  void Resize(int length);
+  bool Get(int s) { unsigned u = s + 1; return (bits[u >> 6] >> (u & 63)) & 1; } // s in [-1,length]
+  void Set(int s) { unsigned u = s + 1; bits[u >> 6] |= 1ULL << (u & 63); }
+  void Clear(int s) { unsigned u = s + 1; bits[u >> 6] &= ~(1ULL << (u & 63)); }
+  int Next(int s, int dir);
+  long Count(void);
+  void Save(Checkpoint &c);
+  bool Restore(Checkpoint &c);
+
+private:
+  int length;
+  int n_words;
+  uint64_t *bits; // bit s+1 is site s
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "bonds_lmp.h"
+#include "atom.h"
+#include "force.h"
+#include "special.h"
+#include "domain.h"
+#include <cmath>
+
+Bonds_lmp::Bonds_lmp(LAMMPS_NS::LAMMPS *lmp_ptr)
+{
+   lmp = lmp_ptr;
+   n_added = n_removed = 0;
+   n_stored = n_deleted = n_missing = n_full = 0;
+   max_length = new_length = 0.;
+   changed = false;
+}
+
+bool Bonds_lmp::owned(int m)
+{
+   return m >= 0 && m < lmp->atom->nlocal;
+}
+
+void Bonds_lmp::add(int bond_type, int id1, int id2)
+{
+   LAMMPS_NS::Atom *atom = lmp->atom;
+   int ids[2] = {id1, id2};
+
+   //as create_bonds: stored on the owner of id1, and also on the owner of id2 without newton_bond
+   for (int a = 0; a < 2; a++)
+   {
+      if (a == 1 && lmp->force->newton_bond) break;
+
+      int m = atom->map(ids[a]);
+      if (!owned(m)) continue;
+
+      if (atom->num_bond[m] == atom->bond_per_atom)
+      {
+         n_full++;
+         continue;
+      }
+      atom->bond_type[m][atom->num_bond[m]] = bond_type;
+      atom->bond_atom[m][atom->num_bond[m]] = ids[1-a];
+      atom->num_bond[m]++;
+      if (a == 0) n_stored++;
+
+      //the partner must be owned or ghost to build the topology
+      int p = atom->map(ids[1-a]);
+      if (p < 0) n_missing++;
+      else if (a == 0)
+      {
+         double dx = atom->x[p][0] - atom->x[m][0];
+         double dy = atom->x[p][1] - atom->x[m][1];
+         double dz = atom->x[p][2] - atom->x[m][2];
+         lmp->domain->minimum_image(dx, dy, dz);
+         max_length = fmax(max_length, sqrt(dx*dx + dy*dy + dz*dz));
+      }
+   }
+
+   n_added++;
+}
+
+void Bonds_lmp::remove(int bond_type, int id1, int id2)
+{
+   LAMMPS_NS::Atom *atom = lmp->atom;
+   int m1 = atom->map(id1);
+   int m2 = atom->map(id2);
+
+   //the bond may be stored on either atom (e.g. bonds read from the data file)
+   if (owned(m1) && remove_from(m1, bond_type, id2)) n_deleted++;
+   if (owned(m2) && remove_from(m2, bond_type, id1) && lmp->force->newton_bond) n_deleted++;
+
+   n_removed++;
+}
+
+void Bonds_lmp::retype(int old_type, int new_type, int id1, int id2)
+{
+   LAMMPS_NS::Atom *atom = lmp->atom;
+   int ids[2] = {id1, id2};
+
+   //type of the bond wherever it is stored, no change in topology size
+   for (int a = 0; a < 2; a++)
+   {
+      int m = atom->map(ids[a]);
+      if (!owned(m)) continue;
+      for (int k = 0; k < atom->num_bond[m]; k++)
+         if (atom->bond_type[m][k] == old_type && atom->bond_atom[m][k] == ids[1-a])
+            atom->bond_type[m][k] = new_type;
+   }
+}
+
+bool Bonds_lmp::remove_from(int m, int bond_type, int partner)
+{
+   LAMMPS_NS::Atom *atom = lmp->atom;
+
+   for (int k = 0; k < atom->num_bond[m]; k++)
+      if (atom->bond_type[m][k] == bond_type && atom->bond_atom[m][k] == partner)
+      {
+         int last = atom->num_bond[m] - 1;
+         atom->bond_type[m][k] = atom->bond_type[m][last];
+         atom->bond_atom[m][k] = atom->bond_atom[m][last];
+         atom->num_bond[m]--;
+         return true;
+      }
+
+   return false;
+}
+
+bool Bonds_lmp::commit(bool in_run)
+{
+   LAMMPS_NS::Atom *atom = lmp->atom;
+   int local[4] = {n_stored, n_deleted, n_missing, n_full};
+   int global[4];
+
+   //check that every bond was found by exactly one rank
+   MPI_Allreduce(local, global, 4, MPI_INT, MPI_SUM, lmp->world);
+   MPI_Allreduce(&max_length, &new_length, 1, MPI_DOUBLE, MPI_MAX, lmp->world);
+
+   bool ok = true;
+   if (global[3] > 0) { error = "No room for new bonds, increase extra/bond/per/atom"; ok = false; }
+   else if (global[0] != n_added) { error = "Atoms of new bonds not found"; ok = false; }
+   else if (global[1] != n_removed) { error = "Bonds to remove not found"; ok = false; }
+   else if (global[2] > 0) { error = "Atoms of new bonds are farther apart than the ghost cutoff"; ok = false; }
+
+   changed = (n_added > 0 || n_removed > 0);
+   atom->nbonds += global[0] - global[1];
+   n_added = n_removed = 0;
+   n_stored = n_deleted = n_missing = n_full = 0;
+   max_length = 0.;
+
+   if (!ok || !changed) return ok;
+
+   //1-2, 1-3, 1-4 neighbours change with the bonds (as create_bonds does)
+   int maxspecial = atom->maxspecial;
+   LAMMPS_NS::Special special(lmp);
+   special.build();
+
+   //inside a run the per-atom arrays exchanged by the ranks must keep their size;
+   //the bond list and the special flags of the pair list are rebuilt by the
+   //reneighboring the caller forces at the next timestep, otherwise by the next setup
+   if (in_run && atom->maxspecial > maxspecial)
+   {
+      error = "No room for new special neighbours inside the run, increase extra/special/per/atom";
+      return false;
+   }
+
+   return true;
+}
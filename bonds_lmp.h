@@ -0,0 +1,45 @@
+#include <lammps.h>
+#include <mpi.h>
+#include <string>
+
+#ifndef BONDS_LMP_H
+#define BONDS_LMP_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Adds and removes bonds by atom tag directly in the
+// bond arrays of LAMMPS, on the ranks owning the atoms,
+// instead of going through parsed commands
+/////////////////////////////////////////////
+class Bonds_lmp
+{
+public:
+
+    string error;
+    double new_length;  // longest bond added by the last commit, on all ranks
+    bool changed;       // the last commit added or removed bonds
+
+    Bonds_lmp(LAMMPS_NS::LAMMPS *lmp);
+
+    void add(int bond_type, int id1, int id2);
+    void remove(int bond_type, int id1, int id2);
+    void retype(int old_type, int new_type, int id1, int id2);
+    bool commit(bool in_run);
+
+private:
+
+    LAMMPS_NS::LAMMPS *lmp;
+    int n_added;      // bonds added since last commit, on all ranks
+    int n_removed;    // bonds removed since last commit, on all ranks
+    int n_stored;     // bonds added on this rank
+    int n_deleted;    // bonds removed on this rank
+    int n_missing;    // added bonds whose partner is not known on this rank
+    int n_full;       // atoms of this rank without room for another bond
+    double max_length; // longest bond added on this rank
+
+    bool owned(int m);
+    bool remove_from(int m, int bond_type, int partner);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "checkpoint.h"
+#include <cstring>
+
+/////////////////////////////////////////////
+// Checkpoint constructor, no data
+/////////////////////////////////////////////
+Checkpoint::Checkpoint()
+{
+   pos = 0;
+}
+
+void Checkpoint::Clear(void)
+{
+   data.clear();
+   pos = 0;
+}
+
+/////////////////////////////////////////////
+// Add size bytes at the end of the data
+/////////////////////////////////////////////
+void Checkpoint::Put(const void *bytes, size_t size)
+{
+   data.insert(data.end(), (const char *)bytes, (const char *)bytes + size);
+}
+
+/////////////////////////////////////////////
+// Add the data of another checkpoint, e.g. a state saved earlier
+/////////////////////////////////////////////
+void Checkpoint::Append(const Checkpoint &other)
+{
+   data.insert(data.end(), other.data.begin(), other.data.end());
+}
+
+/////////////////////////////////////////////
+// Next size bytes of the data, false if there are not so many left
+/////////////////////////////////////////////
+bool Checkpoint::Get(void *bytes, size_t size)
+{
+   if (size > data.size() - pos)
+   {
+      error = "Checkpoint is shorter than expected";
+      return false;
+   }
+
+   memcpy(bytes, data.data() + pos, size);
+   pos += size;
+
+   return true;
+}
+
+/////////////////////////////////////////////
+// Write the data to fileName after magic (8 bytes), through a temporary
+// file renamed at the end
+/////////////////////////////////////////////
+bool Checkpoint::Write(string fileName, const char *magic)
+{
+   string tmp = fileName + ".tmp";
+   FILE *fp = fopen(tmp.c_str(), "wb");
+   if (fp == NULL)
+   {
+      error = "Cannot open file " + tmp;
+      return false;
+   }
+
+   int64_t size = data.size();
+   fwrite(magic, 1, 8, fp);
+   fwrite(&size, sizeof(int64_t), 1, fp);
+   fwrite(data.data(), 1, data.size(), fp);
+
+   bool ok = !ferror(fp);
+   if (fflush(fp) != 0 || fclose(fp) != 0)
+      ok = false;
+   if (!ok || rename(tmp.c_str(), fileName.c_str()) != 0)
+   {
+      error = "Cannot write file " + fileName;
+      return false;
+   }
+
+   return true;
+}
+
+/////////////////////////////////////////////
+// Read the data of fileName, which must begin with magic, to be taken back with Get
+/////////////////////////////////////////////
+bool Checkpoint::Read(string fileName, const char *magic)
+{
+   FILE *fp = fopen(fileName.c_str(), "rb");
+   if (fp == NULL)
+   {
+      error = "Cannot open file " + fileName;
+      return false;
+   }
+
+   char head[8];
+   int64_t size;
+   bool ok = fread(head, 1, 8, fp) == 8 && memcmp(head, magic, 8) == 0 && fread(&size, sizeof(int64_t), 1, fp) == 1 && size >= 0;
+   if (ok)
+   {
+      data.resize(size);
+      ok = fread(data.data(), 1, size, fp) == (size_t)size;
+   }
+   fclose(fp);
+   pos = 0;
+
+   if (!ok)
+   {
+      error = fileName + " is truncated or not of the expected kind";
+      data.clear();
+   }
+
+   return ok;
+}
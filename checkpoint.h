@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+using namespace std;
+
+// layout of the checkpoint file, all values in native byte order:
+//  "LECHKP1\0", int64 size of the data, then the data as put by the
+//  savers (driver, Extrusion, Contacts_lmp), read back in the same order;
+//  the binary CTCF and state files have the same layout with their own magic
+#define CHECKPOINT_MAGIC "LECHKP1"
+
+/////////////////////////////////////////////
+// Binary state to resume a run from: the parts are put in
+// memory one after the other, and the file is written aside
+// and renamed, so a run stopped while writing it leaves the
+// previous checkpoint intact
+/////////////////////////////////////////////
+class Checkpoint
+{
+
+public:
+  string error;
+
+  Checkpoint();
+
+  void Clear(void);
+  void Put(const void *data, size_t size);
+  void Append(const Checkpoint &other);
+  bool Get(void *data, size_t size);
+  bool Write(string fileName, const char *magic = CHECKPOINT_MAGIC);
+  bool Read(string fileName, const char *magic = CHECKPOINT_MAGIC);
+  bool Empty(void) { return data.empty(); }
+
+private:
+  vector<char> data;
+  size_t pos; // next byte read by Get
+};
+
+#endif
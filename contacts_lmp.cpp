@@ -0,0 +1,193 @@
+#include "contacts_lmp.h"
+#include <library.h>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+Contacts_lmp::Contacts_lmp(LAMMPS_NS::LAMMPS *lmp_ptr, int length_, int bin_, double cutoff_, bool full_)
+{
+   lmp = lmp_ptr;
+   length = length_;
+   bin = bin_;
+   n_bins = (length + bin - 1) / bin;
+   cutoff = cutoff_;
+   full = full_;
+   n_samples = 0;
+
+   local.assign((size_t)n_bins * (n_bins + 1) / 2, 0);
+   int me;
+   MPI_Comm_rank(lmp->world, &me);
+   if (me == 0) total.assign(local.size(), 0);
+}
+
+size_t Contacts_lmp::index(int bi, int bj)
+{
+   //upper triangle row by row, as the contact map of Stats1D
+   return (size_t)bi * n_bins - (size_t)bi * (bi - 1) / 2 + (bj - bi);
+}
+
+int Contacts_lmp::cell_of(double *r, int *c)
+{
+   for (int d = 0; d < 3; d++)
+      c[d] = min(n_cells[d] - 1, max(0, (int)((r[d] - lo[d]) / cell_size)));
+   return (c[2] * n_cells[1] + c[1]) * n_cells[0] + c[0];
+}
+
+void Contacts_lmp::sample()
+{
+   int nlocal = *(int *) lammps_extract_global(lmp, "nlocal");
+   int nghost = *(int *) lammps_extract_global(lmp, "nghost");
+   double **x = (double **) lammps_extract_atom(lmp, "x");
+   LAMMPS_NS::tagint *tag = (LAMMPS_NS::tagint *) lammps_extract_atom(lmp, "id");
+   int n = nlocal + nghost;
+   int c[3];
+
+   n_samples++;
+
+   //region of the beads of the chain known to this rank, owned or ghost
+   double hi[3];
+   int n_beads = 0;
+   for (int d = 0; d < 3; d++) { lo[d] = HUGE_VAL; hi[d] = -HUGE_VAL; }
+   for (int a = 0; a < n; a++)
+   {
+      if (tag[a] < 1 || tag[a] > length) continue;
+      n_beads++;
+      for (int d = 0; d < 3; d++)
+      {
+         lo[d] = min(lo[d], x[a][d]);
+         hi[d] = max(hi[d], x[a][d]);
+      }
+   }
+   if (n_beads == 0) return;
+
+   //cells not smaller than the cutoff, and not many more than the beads
+   cell_size = cutoff;
+   while (true)
+   {
+      for (int d = 0; d < 3; d++) n_cells[d] = max(1, (int)((hi[d] - lo[d]) / cell_size));
+      if ((double)n_cells[0] * n_cells[1] * n_cells[2] <= 2. * n_beads + 27.) break;
+      cell_size *= 2.;
+   }
+
+   head.assign(n_cells[0] * n_cells[1] * n_cells[2], -1);
+   next.resize(n);
+   for (int a = 0; a < n; a++)
+   {
+      if (tag[a] < 1 || tag[a] > length) continue;
+      int k = cell_of(x[a], c);
+      next[a] = head[k];
+      head[k] = a;
+   }
+
+   //each pair is counted by the rank owning the bead of lower tag
+   double cut2 = cutoff * cutoff;
+   for (int i = 0; i < nlocal; i++)
+   {
+      if (tag[i] < 1 || tag[i] > length) continue;
+      cell_of(x[i], c);
+      int bi = (tag[i] - 1) / bin;
+
+      for (int kz = max(0, c[2] - 1); kz <= min(n_cells[2] - 1, c[2] + 1); kz++)
+         for (int ky = max(0, c[1] - 1); ky <= min(n_cells[1] - 1, c[1] + 1); ky++)
+            for (int kx = max(0, c[0] - 1); kx <= min(n_cells[0] - 1, c[0] + 1); kx++)
+               for (int j = head[(kz * n_cells[1] + ky) * n_cells[0] + kx]; j >= 0; j = next[j])
+               {
+                  if (tag[j] <= tag[i]) continue;
+                  double dx = x[j][0] - x[i][0];
+                  double dy = x[j][1] - x[i][1];
+                  double dz = x[j][2] - x[i][2];
+                  if (dx*dx + dy*dy + dz*dz < cut2) local[index(bi, (tag[j] - 1) / bin)]++;
+               }
+   }
+}
+
+bool Contacts_lmp::write(string fileName)
+{
+   int me;
+   MPI_Comm_rank(lmp->world, &me);
+
+   //counts of all the ranks since the last write are added to the total on rank 0
+   vector<uint64_t> sum(me == 0 ? local.size() : 0);
+   MPI_Reduce(local.data(), me == 0 ? sum.data() : NULL, (int) local.size(), MPI_UINT64_T, MPI_SUM, 0, lmp->world);
+   fill(local.begin(), local.end(), 0);
+   if (me != 0) return true;
+   for (size_t k = 0; k < total.size(); k++) total[k] += sum[k];
+
+   //written aside and renamed, a checkpoint is never left half written
+   string tmp = fileName + ".tmp";
+   FILE *fp = fopen(tmp.c_str(), "wb");
+   if (fp == NULL)
+   {
+      error = "Cannot open file " + tmp;
+      return false;
+   }
+
+   const char magic[8] = "LECMAP1";
+   int32_t sizes[4] = {n_bins, bin, length, full ? 1 : 0};
+   int64_t samples = n_samples;
+   fwrite(magic, 1, 8, fp);
+   fwrite(sizes, sizeof(int32_t), 4, fp);
+   fwrite(&cutoff, sizeof(double), 1, fp);
+   fwrite(&samples, sizeof(int64_t), 1, fp);
+   if (full)
+   {
+      vector<uint64_t> row(n_bins);
+      for (int bi = 0; bi < n_bins; bi++)
+      {
+         for (int bj = 0; bj < n_bins; bj++) row[bj] = total[bi <= bj ? index(bi, bj) : index(bj, bi)];
+         fwrite(row.data(), sizeof(uint64_t), n_bins, fp);
+      }
+   }
+   else fwrite(total.data(), sizeof(uint64_t), total.size(), fp);
+
+   bool ok = !ferror(fp);
+   if (fclose(fp) != 0) ok = false;
+   if (!ok || rename(tmp.c_str(), fileName.c_str()) != 0)
+   {
+      error = "Cannot write contact map to " + fileName;
+      return false;
+   }
+
+   return true;
+}
+
+void Contacts_lmp::save(Checkpoint &c)
+{
+   //called on rank 0 after write, all the counts are in total
+   int64_t samples = n_samples;
+   int32_t sizes[2] = {n_bins, bin};
+   c.Put(&samples, sizeof(int64_t));
+   c.Put(sizes, sizeof(sizes));
+   c.Put(total.data(), total.size() * sizeof(uint64_t));
+}
+
+bool Contacts_lmp::restore(Checkpoint &c)
+{
+   int64_t samples;
+   int32_t sizes[2];
+   vector<uint64_t> counts(local.size());
+
+   if (!c.Get(&samples, sizeof(int64_t)) || !c.Get(sizes, sizeof(sizes)))
+   {
+      error = c.error;
+      return false;
+   }
+   if (sizes[0] != n_bins || sizes[1] != bin)
+   {
+      error = "Checkpoint has a contact map with other bins";
+      return false;
+   }
+   if (!c.Get(counts.data(), counts.size() * sizeof(uint64_t)))
+   {
+      error = c.error;
+      return false;
+   }
+
+   //every rank reads the checkpoint, the counts are kept on rank 0
+   n_samples = samples;
+   int me;
+   MPI_Comm_rank(lmp->world, &me);
+   if (me == 0) total.swap(counts);
+
+   return true;
+}
@@ -0,0 +1,53 @@
+#include <lammps.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "checkpoint.h"
+
+#ifndef CONTACTS_LMP_H
+#define CONTACTS_LMP_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Contact map of the chain accumulated from the coordinates
+// in LAMMPS: each rank counts the pairs of beads closer than
+// the cutoff with a cell list over its owned and ghost atoms,
+// the counts are reduced on rank 0 only when written
+/////////////////////////////////////////////
+class Contacts_lmp
+{
+public:
+
+    string error;
+    long n_samples;   // configurations sampled since the start
+
+    Contacts_lmp(LAMMPS_NS::LAMMPS *lmp, int length, int bin, double cutoff, bool full);
+
+    void sample();
+    bool write(string fileName);
+    void save(Checkpoint &c);
+    bool restore(Checkpoint &c);
+
+private:
+
+    LAMMPS_NS::LAMMPS *lmp;
+    int length;          // beads of the chain, tags 1 to length
+    int bin;             // beads per bin
+    int n_bins;
+    double cutoff;
+    bool full;           // whole n_bins x n_bins matrix instead of the upper triangle
+    vector<uint64_t> local;  // pairs counted on this rank since the last write, upper triangle
+    vector<uint64_t> total;  // all the pairs, on rank 0
+    vector<int> head;    // first atom of each cell
+    vector<int> next;    // next atom in the same cell
+    double lo[3];        // corner of the cells
+    double cell_size;
+    int n_cells[3];
+
+    size_t index(int bi, int bj);
+    int cell_of(double *r, int *c);
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "eventqueue.h"
+#include <cmath>
+
+/////////////////////////////////////////////
+// EventQueue constructor, all channels never fire
+/////////////////////////////////////////////
+EventQueue::EventQueue(int n_channels)
+{
+   n = 0;
+   time = nullptr;
+   heap = nullptr;
+   pos = nullptr;
+   Resize(n_channels);
+}
+
+EventQueue::~EventQueue()
+{
+   delete[] time;
+   delete[] heap;
+   delete[] pos;
+}
+
+/////////////////////////////////////////////
+// Reallocate for n_channels channels, all never firing
+/////////////////////////////////////////////
+void EventQueue::Resize(int n_channels)
+{
+   delete[] time;
+   delete[] heap;
+   delete[] pos;
+
+   n = n_channels;
+   time = new double[n];
+   heap = new int[n];
+   pos = new int[n];
+   for (int c = 0; c < n; c++)
+   {
+      time[c] = HUGE_VAL;
+      heap[c] = c;
+      pos[c] = c;
+   }
+}
+
+/////////////////////////////////////////////
+// Add channels up to n_channels, never firing, keeping the times of the others
+/////////////////////////////////////////////
+void EventQueue::Grow(int n_channels)
+{
+   if (n_channels <= n)
+      return;
+
+   double *newTime = new double[n_channels];
+   int *newHeap = new int[n_channels];
+   int *newPos = new int[n_channels];
+
+   for (int c = 0; c < n; c++)
+   {
+      newTime[c] = time[c];
+      newHeap[c] = heap[c];
+      newPos[c] = pos[c];
+   }
+   // never firing channels at the bottom keep the heap ordered
+   for (int c = n; c < n_channels; c++)
+   {
+      newTime[c] = HUGE_VAL;
+      newHeap[c] = c;
+      newPos[c] = c;
+   }
+
+   delete[] time;
+   delete[] heap;
+   delete[] pos;
+   time = newTime;
+   heap = newHeap;
+   pos = newPos;
+   n = n_channels;
+}
+
+/////////////////////////////////////////////
+// Set the firing time of a channel
+/////////////////////////////////////////////
+void EventQueue::Update(int channel, double t)
+{
+   double old = time[channel];
+
+   time[channel] = t;
+   if (t < old)
+      SiftUp(pos[channel]);
+   else if (t > old)
+      SiftDown(pos[channel]);
+}
+
+/////////////////////////////////////////////
+// Firing time of a channel
+/////////////////////////////////////////////
+double EventQueue::Time(int channel)
+{
+   return time[channel];
+}
+
+/////////////////////////////////////////////
+// Channel firing first
+/////////////////////////////////////////////
+int EventQueue::Top(void)
+{
+   return heap[0];
+}
+
+/////////////////////////////////////////////
+// Time of the first firing
+/////////////////////////////////////////////
+double EventQueue::TopTime(void)
+{
+   return time[heap[0]];
+}
+
+/////////////////////////////////////////////
+// Times and heap order of the channels, as they are
+/////////////////////////////////////////////
+void EventQueue::Save(Checkpoint &c)
+{
+   c.Put(&n, sizeof(int));
+   c.Put(time, n * sizeof(double));
+   c.Put(heap, n * sizeof(int));
+   c.Put(pos, n * sizeof(int));
+}
+
+bool EventQueue::Restore(Checkpoint &c)
+{
+   int n_channels;
+   if (!c.Get(&n_channels, sizeof(int)))
+      return false;
+
+   Resize(n_channels);
+   return c.Get(time, n * sizeof(double)) && c.Get(heap, n * sizeof(int)) && c.Get(pos, n * sizeof(int));
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+void EventQueue::Swap(int a, int b)
+{
+   int ca = heap[a];
+   int cb = heap[b];
+
+   heap[a] = cb;
+   heap[b] = ca;
+   pos[cb] = a;
+   pos[ca] = b;
+}
+
+void EventQueue::SiftUp(int k)
+{
+   while (k > 0)
+   {
+      int parent = (k - 1) / 2;
+      if (time[heap[parent]] <= time[heap[k]])
+         break;
+      Swap(k, parent);
+      k = parent;
+   }
+}
+
+void EventQueue::SiftDown(int k)
+{
+   while (true)
+   {
+      int child = 2 * k + 1;
+      if (child >= n)
+         break;
+      if (child + 1 < n && time[heap[child + 1]] < time[heap[child]])
+         child++;
+      if (time[heap[k]] <= time[heap[child]])
+         break;
+      Swap(k, child);
+      k = child;
+   }
+}
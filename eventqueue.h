@@ -0,0 +1,37 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include "checkpoint.h"
+
+/////////////////////////////////////////////
+// Indexed binary min-heap of the putative firing times
+// of the reaction channels (next-reaction method)
+/////////////////////////////////////////////
+class EventQueue
+{
+
+public:
+  EventQueue(int n_channels = 0);
+  ~EventQueue();
+
+  void Resize(int n_channels);
+  void Grow(int n_channels);
+  void Update(int channel, double t);
+  double Time(int channel);
+  int Top(void);
+  double TopTime(void);
+  void Save(Checkpoint &c);
+  bool Restore(Checkpoint &c);
+
+private:
+  int n;
+  double *time; // putative firing time of each channel (HUGE_VAL if never)
+  int *heap;    // channels ordered as a binary heap on time
+  int *pos;     // position of each channel in heap
+
+  void Swap(int a, int b);
+  void SiftUp(int k);
+  void SiftDown(int k);
+};
+
+#endif
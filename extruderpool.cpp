@@ -0,0 +1,157 @@
+#include "extruderpool.h"
+#include <algorithm>
+
+using namespace std;
+
+/////////////////////////////////////////////
+// ExtruderPool constructor, no extruder bound
+/////////////////////////////////////////////
+ExtruderPool::ExtruderPool(int capacity_)
+{
+   capacity = 0;
+   Allocate(max(capacity_, 1));
+   n = 0;
+}
+
+ExtruderPool::~ExtruderPool()
+{
+   Release();
+}
+
+/////////////////////////////////////////////
+// Bind an extruder and return its handle, growing the pool if it is full
+/////////////////////////////////////////////
+int ExtruderPool::Add(int i, int j, int64_t timeI, int64_t timeJ, int idx)
+{
+   if (Full())
+      Allocate(2 * capacity);
+
+   int h = handle[n++];
+   site[0][h] = i;
+   site[1][h] = j;
+   arrival[0][h] = timeI;
+   arrival[1][h] = timeJ;
+   index[h] = idx;
+
+   return h;
+}
+
+/////////////////////////////////////////////
+// Unbind the extruder of handle h; the last bound extruder takes
+// its position in the dense list, the handles do not change
+/////////////////////////////////////////////
+void ExtruderPool::Remove(int h)
+{
+   int p = pos[h];
+   int last = handle[--n];
+
+   handle[p] = last;
+   pos[last] = p;
+   handle[n] = h;
+   pos[h] = n;
+}
+
+/////////////////////////////////////////////
+// Unbind all extruders and reserve capacity handles
+/////////////////////////////////////////////
+void ExtruderPool::Clear(int capacity_)
+{
+   Release();
+   capacity = 0;
+   Allocate(max(capacity_, 1));
+   n = 0;
+}
+
+/////////////////////////////////////////////
+// All handles, bound and free, in the order of the dense list
+/////////////////////////////////////////////
+void ExtruderPool::Save(Checkpoint &c)
+{
+   c.Put(&capacity, sizeof(int));
+   c.Put(&n, sizeof(int));
+   for (int side = 0; side < 2; side++)
+   {
+      c.Put(site[side], capacity * sizeof(int));
+      c.Put(arrival[side], capacity * sizeof(int64_t));
+   }
+   c.Put(index, capacity * sizeof(int));
+   c.Put(handle, capacity * sizeof(int));
+   c.Put(pos, capacity * sizeof(int));
+}
+
+bool ExtruderPool::Restore(Checkpoint &c)
+{
+   int capacity_, n_;
+   if (!c.Get(&capacity_, sizeof(int)) || !c.Get(&n_, sizeof(int)))
+      return false;
+
+   Clear(capacity_);
+   n = n_;
+   bool ok = true;
+   for (int side = 0; side < 2; side++)
+      ok = ok && c.Get(site[side], capacity * sizeof(int)) && c.Get(arrival[side], capacity * sizeof(int64_t));
+
+   return ok && c.Get(index, capacity * sizeof(int)) && c.Get(handle, capacity * sizeof(int)) && c.Get(pos, capacity * sizeof(int));
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+// Grow the arrays to new_capacity handles, keeping the extruders and their handles
+void ExtruderPool::Allocate(int new_capacity)
+{
+   int *newSite[2], *newIndex = new int[new_capacity];
+   int64_t *newArrival[2];
+   int *newHandle = new int[new_capacity], *newPos = new int[new_capacity];
+
+   for (int side = 0; side < 2; side++)
+   {
+      newSite[side] = new int[new_capacity];
+      newArrival[side] = new int64_t[new_capacity];
+   }
+   if (capacity > 0)
+   {
+      for (int side = 0; side < 2; side++)
+      {
+         copy(site[side], site[side] + capacity, newSite[side]);
+         copy(arrival[side], arrival[side] + capacity, newArrival[side]);
+      }
+      copy(index, index + capacity, newIndex);
+      copy(handle, handle + capacity, newHandle);
+      copy(pos, pos + capacity, newPos);
+   }
+   for (int h = capacity; h < new_capacity; h++)
+   {
+      newHandle[h] = h;
+      newPos[h] = h;
+   }
+
+   Release();
+   for (int side = 0; side < 2; side++)
+   {
+      site[side] = newSite[side];
+      arrival[side] = newArrival[side];
+   }
+   index = newIndex;
+   handle = newHandle;
+   pos = newPos;
+   capacity = new_capacity;
+}
+
+void ExtruderPool::Release(void)
+{
+   if (capacity == 0)
+      return;
+
+   for (int side = 0; side < 2; side++)
+   {
+      delete[] site[side];
+      delete[] arrival[side];
+   }
+   delete[] index;
+   delete[] handle;
+   delete[] pos;
+}
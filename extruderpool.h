@@ -0,0 +1,42 @@
+#include <stdint.h>
+
+#ifndef EXTRUDERPOOL_H
+#define EXTRUDERPOOL_H
+
+#include "checkpoint.h"
+
+/////////////////////////////////////////////
+// Bound extruders as a structure of arrays. Each extruder
+// keeps its handle while bound, handles are reused once it
+// unbinds; the bound handles are also kept in a dense list,
+// so removal is O(1) and the capacity grows when needed.
+/////////////////////////////////////////////
+class ExtruderPool
+{
+
+public:
+  int n;              // bound extruders
+  int capacity;       // handles available before growing
+  int *site[2];       // per handle, sites of left (0) and right (1) legs, site[0] < site[1]
+  int64_t *arrival[2]; // per handle, event count at the last move of each leg
+  int *index;         // per handle, unique progressive index of the extruder
+  int *handle;        // handles of the bound extruders (first n) and of the free ones
+  int *pos;           // position of each handle in handle
+
+  ExtruderPool(int capacity = 16);
+  ~ExtruderPool();
+
+  int Add(int i, int j, int64_t timeI, int64_t timeJ, int idx);
+  void Remove(int h);
+  void Clear(int capacity);
+  bool Full(void) { return n == capacity; }
+  bool Bound(int h) { return pos[h] < n; }
+  void Save(Checkpoint &c);
+  bool Restore(Checkpoint &c);
+
+private:
+  void Allocate(int capacity);
+  void Release(void);
+};
+
+#endif
@@ -1,5 +1,4 @@
 #include "extrusion.h"
-#include "random"
 /////////////////////////////////////////////
 // Extrusion constructor
 /////////////////////////////////////////////
@@ -9,18 +8,17 @@ Extrusion::Extrusion(Parameters parm)
       cerr << "Initializing extrusion..." << endl;
 
    length = parm.length;
+   chainLength = parm.length / parm.n_chains;
    seed = parm.seed;
 
    // allocate memory
-   map = AlloArrayInt(parm.length);
-   extrList = new int[parm.n_extr_max][5];
-   ctcf = new int[parm.length];
-   for (int i = 0; i < parm.length; i++)
-      ctcf[i] = 0;
+   pool.Clear(parm.n_extr_max);
+   barrier = new BitPlane[2];
+   barrier[0].Resize(parm.length);
+   barrier[1].Resize(parm.length);
    nCTCF = 0;
-   occupiedSites = new int[parm.length];
-   for (int i = 0; i < parm.length; i++)
-      occupiedSites[i] = 0;
+   ownCTCF = true;
+   occupied.Resize(parm.length);
    cnt_extr = 0;   
 
    // set private variables
@@ -34,9 +32,17 @@ Extrusion::Extrusion(Parameters parm)
    k_step = parm.k_step;
    k_cross_ctcf = parm.k_cross_ctcf;
    allow_overcome = parm.allow_overcome;
+   next_reaction = (parm.engine == "next_reaction");
    n_extr_tot = parm.n_extr_tot;
    n_extr_max = parm.n_extr_max;
 
+   // kernels for the policies of this run
+   SetKernels();
+
+   // arrays of extruder legs
+   AlloLegs(0);
+   simTime = 0.;
+
    // set output defaults
    bool add_link = false;
    int add_link_i = -1;
@@ -49,6 +55,8 @@ Extrusion::Extrusion(Parameters parm)
    reaction_name[2] = "Random unbind";
    reaction_name[3] = "Random step";
    reaction_name[4] = "Overcome ctcf";
+   for (int i = 0; i < NREACT + 1; i++)
+      n_events[i] = 0;
 
    if (seed == -1)
    {
@@ -56,8 +64,68 @@ Extrusion::Extrusion(Parameters parm)
       seed = rd();
    }
    cout << "Random seed = " << seed << endl;
-   iRand(10, seed); // initialize the random number generator
-   DRand(seed);     // initialize the random number generator
+   rng.Seed(seed, parm.replica, parm.rank); // initialize the random number generator
+
+   // schedule binding (next-reaction method)
+   SetChannelRate(0, BindingRate());
+}
+
+/////////////////////////////////////////////
+// Extrusion destructor
+/////////////////////////////////////////////
+Extrusion::~Extrusion()
+{
+   if (ownCTCF)
+      delete[] barrier;
+   delete[] legPrev;
+   delete[] legNext;
+   delete[] legStatus;
+   delete[] legSetPos;
+   for (int status = 1; status < 3; status++)
+      delete[] legSet[status];
+   delete[] chRate;
+}
+
+/////////////////////////////////////////////
+// Choose the instantiation of the kernels for allow_overcome and k_cross_ctcf,
+// once: the hot functions then run without testing them (nor debug)
+/////////////////////////////////////////////
+void Extrusion::SetKernels(void)
+{
+   int policy = (allow_overcome ? OVERCOME : 0) | (k_cross_ctcf > 0. ? CROSS : 0);
+
+   switch (policy)
+   {
+   case 0:
+      BindKernel<0>(kernel[0]);
+      BindKernel<DEBUG>(kernel[1]);
+      break;
+   case OVERCOME:
+      BindKernel<OVERCOME>(kernel[0]);
+      BindKernel<OVERCOME | DEBUG>(kernel[1]);
+      break;
+   case CROSS:
+      BindKernel<CROSS>(kernel[0]);
+      BindKernel<CROSS | DEBUG>(kernel[1]);
+      break;
+   case OVERCOME | CROSS:
+      BindKernel<OVERCOME | CROSS>(kernel[0]);
+      BindKernel<OVERCOME | CROSS | DEBUG>(kernel[1]);
+      break;
+   }
+}
+
+template <int F>
+void Extrusion::BindKernel(Kernel &k)
+{
+   k.event = &Extrusion::Event<F>;
+   k.drawTime = &Extrusion::DrawTime<F>;
+   k.applyEvent = &Extrusion::ApplyEvent<F>;
+   k.calculatePropensities = &Extrusion::CalculatePropensities<F>;
+   k.addExtruder = &Extrusion::AddExtruder<F>;
+   k.removeExtruder = &Extrusion::RemoveExtruder<F>;
+   k.updateLegStatus = &Extrusion::UpdateLegStatus<F>;
+   k.checkStepOk = &Extrusion::CheckStepOk<F>;
 }
 
 /////////////////////////////////////////////
@@ -65,146 +133,216 @@ Extrusion::Extrusion(Parameters parm)
 /////////////////////////////////////////////
 bool Extrusion::Event(bool debug = false)
 {
-   bool ok;
-   int r;
+   return (this->*kernel[debug].event)();
+}
 
-   if (debug)
+template <int F>
+bool Extrusion::Event(void)
+{
+   if (!DrawTime<F>())
+      return false;
+
+   return ApplyEvent<F>();
+}
+
+/////////////////////////////////////////////
+// Time to the next event (tau), the state is not changed yet
+/////////////////////////////////////////////
+bool Extrusion::DrawTime(bool debug = false)
+{
+   return (this->*kernel[debug].drawTime)();
+}
+
+template <int F>
+bool Extrusion::DrawTime(void)
+{
+   if (F & DEBUG)
       cerr << to_string(iTime) + ") Starting Gillespie event" << endl;
 
-   // reset request to lammps
-   add_link = false;
-   delete_link = false;
+   // next-reaction method: earliest channel, propensities are only needed for the debug output and check
+   if (next_reaction)
+   {
+      if ((F & DEBUG) && !CalculatePropensities<F>())
+         return false;
 
-   // Calculate propensities for the different reactions
-   CalculatePropensities(debug);
-   if (propensities[0] < SMALL)
+      if (queue.TopTime() == HUGE_VAL)
+      {
+         exitError = "All propensities are zero";
+         return false;
+      }
+      tau = queue.TopTime() - simTime;
+   }
+   // direct method
+   else
    {
-      exitError = "All propensities are zero";
-      return false;
+      // Calculate propensities for the different reactions
+      if (!CalculatePropensities<F>())
+         return false;
+      if (propensities[0] < SMALL)
+      {
+         exitError = "All propensities are zero";
+         return false;
+      }
+
+      // Time of next reaction
+      tau = log(1. / DRand()) / propensities[0];
    }
 
-   // Time of next reaction
-   tau = log(1. / DRand()) / propensities[0];
-   if (debug)
+   if (F & DEBUG)
       cerr << "tau = " + to_string(tau) << endl;
 
+   return true;
+}
+
+/////////////////////////////////////////////
+// Apply the event whose time was drawn by DrawTime
+/////////////////////////////////////////////
+bool Extrusion::ApplyEvent(bool debug = false)
+{
+   return (this->*kernel[debug].applyEvent)();
+}
+
+template <int F>
+bool Extrusion::ApplyEvent(void)
+{
+   int r;
+
+   // reset request to lammps
+   add_link = false;
+   delete_link = false;
+
+   if (next_reaction)
+      return FireChannel<F>();
+
    // Choose which reaction
    r = SelectReaction();
-   if (debug)
+   if (F & DEBUG)
       cerr << "Selected reaction is r=" + to_string(r) + "  : " + reaction_name[r] << endl;
    if (r < 0)
       return false;
 
    // Apply chosen reaction
-   ok = ApplyReaction(r, debug);
-
-   return ok;
+   return ApplyReaction<F>(r);
 }
 
 /////////////////////////////////////////////
-// Bind an extruder to random sites i and i+1
+// Bind an extruder to random sites i and i+1 of the same chain
 /////////////////////////////////////////////
-bool Extrusion::RandomBind(bool debug = false)
+template <int F>
+bool Extrusion::RandomBind(void)
 {
    cnt_extr++;
-   int i = iRand(length - 1);
-   if (debug)
+   int k = iRand(length - length / chainLength); // pairs of neighbouring sites, chainLength-1 per chain
+   int i = k + k / (chainLength - 1);
+   if (F & DEBUG)
       cerr << to_string(iTime) + ") Random bind extruder at sites " + to_string(i) + "-" + to_string(i + 1) << endl;
-   return AddExtruder(i, i + 1, iTime, iTime, cnt_extr);
+   return AddExtruder<F>(i, i + 1, iTime, iTime, cnt_extr);
 }
 
 /////////////////////////////////////////////
 // Unbind an extruder chosen at random
 /////////////////////////////////////////////
-bool Extrusion::RandomUnbind(bool debug = false)
+template <int F>
+bool Extrusion::RandomUnbind(void)
 {
-   int w = iRand(n_extr_bound);
-   int i = extrList[w][0];
-   int j = extrList[w][1];
-   int iTimeI = extrList[w][2];
-   int iTimeJ = extrList[w][3];
-
-   if (debug)
-      cerr << to_string(iTime) + ") Random unbind extruder from sites " + to_string(i) + "-" + to_string(j) + " (w=" + to_string(w) + ")" << endl;
-   return RemoveExtruder(i, j, iTimeI, iTimeJ);
+   return Unbind<F>(pool.handle[iRand(n_extr_bound)]);
 }
 
 /////////////////////////////////////////////
 // Step extruder forward in sites
 // the argument ctcf_cross indicates if only CTCF sites or only nonCTCF sites are considered
 /////////////////////////////////////////////
-bool Extrusion::RandomStepForward(bool ctcf_cross, bool debug = false)
+template <int F>
+bool Extrusion::RandomStepForward(bool ctcf_cross)
 {
-   int i, j, iTimeI, iTimeJ, index, w, cnt = 0, dir;
-   bool go_ahead, ok;
+   int status = ctcf_cross ? 2 : 1;
 
-   do
+   if (legSetSize[status] == 0)
    {
-      w = iRand(n_extr_bound);
-      i = extrList[w][0];
-      j = extrList[w][1];
-      iTimeI = extrList[w][2];
-      iTimeJ = extrList[w][3];
-      index = extrList[w][4];
-      dir = iRand(2); // 0=move i, 1=move j
-
-      if (debug)
-         cerr << " testing extruder step from " + to_string(i) + "-" + to_string(j) + " (w=" + to_string(w) +
-                     ") direction=" + to_string(dir)
-              << endl;
-
-      // be sure that i<j
-      if (j < i)
-      {
-         i = extrList[w][1];
-         j = extrList[w][0];
-      }
-
-      // if it has reached the ends then unbinds
-      if (i == 0 || j == length - 1)
-      {
-         RemoveExtruder(i, j, iTimeI, iTimeJ);
-         if (debug)
-            cerr << to_string(iTime) + ") Reaches one of the ends and unbinds" << endl;
-         return true;
-      }
-
-      // check if overlaps with something
-      go_ahead = CheckStepOk(w, dir, ctcf_cross, debug);
-
-      // make a step if allowed
-      // from i
-      if (dir == 0 && go_ahead)
-      {
-         RemoveExtruder(i, j, iTimeI, iTimeJ);
-         AddExtruder(i - 1, j, iTime, iTimeJ, index);
+      exitError = "Cannot make extruder step";
+      return false;
+   }
 
-         if (debug)
-            cerr << to_string(iTime) + ") Accepted move to " + to_string(i - 1) + "-" + to_string(j) << endl;
-         return true;
-      }
-      // from j
-      else if (dir == 1 && go_ahead)
-      {
+   // pick directly among the legs that can make this kind of step
+   return StepLeg<F>(legSet[status][iRand(legSetSize[status])]);
+}
 
-         RemoveExtruder(i, j, iTimeI, iTimeJ);
-         AddExtruder(i, j + 1, iTimeI, iTime, index);
+/////////////////////////////////////////////
+// Unbind extruder h
+/////////////////////////////////////////////
+template <int F>
+bool Extrusion::Unbind(int h)
+{
+   if (F & DEBUG)
+      cerr << to_string(iTime) + ") Random unbind extruder from sites " + to_string(pool.site[0][h]) + "-" + to_string(pool.site[1][h]) + " (h=" + to_string(h) + ")" << endl;
+   return RemoveExtruder<F>(h);
+}
 
-         if (debug)
-            cerr << to_string(iTime) + ") Accepted move to " + to_string(i) + "-" + to_string(j + 1) << endl;
-         return true;
-      }
+/////////////////////////////////////////////
+// Step leg 2*h+dir of extruder h outwards, in place
+/////////////////////////////////////////////
+template <int F>
+bool Extrusion::StepLeg(int leg)
+{
+   int h = leg / 2;
+   int dir = leg % 2; // 0=move i, 1=move j
+   int i = pool.site[0][h];
+   int j = pool.site[1][h];
+
+   if (F & DEBUG)
+      cerr << " extruder step from " + to_string(i) + "-" + to_string(j) + " (h=" + to_string(h) +
+                  ") direction=" + to_string(dir)
+           << endl;
+
+   // if it has reached the ends of its chain then unbinds
+   if (i % chainLength == 0 || j % chainLength == chainLength - 1)
+   {
+      RemoveExtruder<F>(h);
+      if (F & DEBUG)
+         cerr << to_string(iTime) + ") Reaches one of the ends and unbinds" << endl;
+      return true;
+   }
 
-      cnt++;
+   // make the step: only the moving leg changes site, the other one and the unbinding are untouched
+   int from = pool.site[dir][h];
+   int to = (dir == 0) ? from - 1 : from + 1;
+   int n_old = map.Decrement(i, j);
+
+   ClearLegStatus(h, dir);
+   UnlinkLeg(h, dir);
+   if (!(F & OVERCOME)) // legs left behind may be free to step
+      RefreshSite<F>(from);
+
+   pool.site[dir][h] = to;
+   pool.arrival[dir][h] = iTime;
+   LinkLeg(h, dir);
+   UpdateLegStatus<F>(h, dir);
+   if (!(F & OVERCOME)) // the new leg may block the ones already there
+      RefreshSite<F>(to);
+   int n_new = map.Increment(pool.site[0][h], pool.site[1][h]);
+
+   // tell lammps to remove the old link if it was the only one, and to add the new one if there was none
+   if (n_old == 0)
+   {
+      delete_link = true;
+      delete_link_i = i;
+      delete_link_j = j;
+   }
+   if (n_new == 1)
+   {
+      add_link = true;
+      add_link_i = pool.site[0][h];
+      add_link_j = pool.site[1][h];
+   }
 
-   } while (cnt < LARGE);
+   if (F & DEBUG)
+      cerr << to_string(iTime) + ") Accepted move to " + to_string(pool.site[0][h]) + "-" + to_string(pool.site[1][h]) << endl;
 
-   exitError = "Cannot make extruder step";
-   return false;
+   return true;
 }
 
 /////////////////////////////////////////////
-// Read ctcf from file
+// Read ctcf from file, as pairs (site type) or in the binary format of WriteCTCF
 /////////////////////////////////////////////
 bool Extrusion::ReadCTCF(string fileName)
 {
@@ -218,43 +356,72 @@ bool Extrusion::ReadCTCF(string fileName)
    //  +2 : bidirectional barrier
 
    int i, ctcf_type;
-   string line;
 
    if ( fileName.empty() )
    {
       cout << "No CTCF file provided" << endl;
       cout << endl;
 
+      return true;
+   }
+
+   TextFile fin;
+   if (!fin.Open(fileName))
+   {
+      exitError = fin.error;
       return false;
    }
-   
-   ifstream fin(fileName);
-   if (fin.is_open())
+
+   // binary file: the planes of the barriers as they are
+   if (fin.Starts(CTCF_MAGIC, 8))
    {
-      while (fin >> i >> ctcf_type)
+      fin.Close();
+      Checkpoint c;
+      int sizes[2]; // length, sites
+      if (!c.Read(fileName, CTCF_MAGIC) || !c.Get(sizes, sizeof(sizes)))
       {
-         if (i < 0 || i >= length)
-         {
-            cout << "CTCF site out of range, i = " << i << endl;
-            exit(1);
-         }
-         else if (ctcf_type != -1 && ctcf_type != 1 && ctcf_type != 2)
-         {
-            cout << "Wrong CTCF type (" << ctcf_type << ")  Must be 1 (left), -1 (right) or 2 (bidirectional)" << endl;
-            exit(1);
-         }
-
-         ctcf[i] = ctcf_type;
-         nCTCF++;
+         exitError = c.error;
+         return false;
+      }
+      if (sizes[0] != length)
+      {
+         exitError = fileName + " is for a chain of " + to_string(sizes[0]) + " sites, not " + to_string(length);
+         return false;
+      }
+      if (!barrier[0].Restore(c) || !barrier[1].Restore(c))
+      {
+         exitError = c.error;
+         return false;
       }
+      nCTCF = sizes[1];
    }
-   else
+   else while (!fin.End())
    {
-      cout << "Cannot open CTCF file "+fileName << endl;
-      exit(1);
-   }
+      if (!fin.Int(i) || !fin.Int(ctcf_type))
+      {
+         exitError = fin.error;
+         return false;
+      }
+      if (i < 0 || i >= length)
+      {
+         exitError = fin.Where() + ": CTCF site out of range, i = " + to_string(i);
+         return false;
+      }
+      if (ctcf_type != -1 && ctcf_type != 1 && ctcf_type != 2)
+      {
+         exitError = fin.Where() + ": wrong CTCF type (" + to_string(ctcf_type) + ")  Must be 1 (left), -1 (right) or 2 (bidirectional)";
+         return false;
+      }
 
-   fin.close();
+      // a leg moving left is stopped by types -1 and 2, one moving right by 1 and 2
+      barrier[0].Clear(i);
+      barrier[1].Clear(i);
+      if (ctcf_type != 1)
+         barrier[0].Set(i);
+      if (ctcf_type != -1)
+         barrier[1].Set(i);
+      nCTCF++;
+   }
 
    cout << "CTCF sites read from " << fileName << endl;
    cout << endl;
@@ -262,6 +429,54 @@ bool Extrusion::ReadCTCF(string fileName)
    return true;
 }
 
+/////////////////////////////////////////////
+// Write the CTCF sites in binary, read back by ReadCTCF without parsing
+/////////////////////////////////////////////
+bool Extrusion::WriteCTCF(string fileName)
+{
+   Checkpoint c;
+   int sizes[2] = {length, nCTCF};
+
+   c.Put(sizes, sizeof(sizes));
+   barrier[0].Save(c);
+   barrier[1].Save(c);
+   if (!c.Write(fileName, CTCF_MAGIC))
+   {
+      exitError = c.error;
+      return false;
+   }
+
+   return true;
+}
+
+/////////////////////////////////////////////
+// Use the CTCF sites of another extruder engine on the same chain,
+// which must outlive this one and not change anymore
+/////////////////////////////////////////////
+bool Extrusion::ShareCTCF(Extrusion &source)
+{
+   if (source.length != length)
+   {
+      exitError = "Cannot share CTCF sites between chains of different length";
+      return false;
+   }
+
+   if (ownCTCF)
+      delete[] barrier;
+   barrier = source.barrier;
+   nCTCF = source.nCTCF;
+   ownCTCF = false;
+
+   // the CTCF sites may change which legs can step
+   for (int w = 0; w < n_extr_bound; w++)
+   {
+      UpdateLegStatus(pool.handle[w], 0);
+      UpdateLegStatus(pool.handle[w], 1);
+   }
+
+   return true;
+}
+
 /////////////////////////////////////////////
 // Print state to file
 /////////////////////////////////////////////
@@ -270,16 +485,14 @@ bool Extrusion::PrintState(string fileName)
    ofstream fout(fileName);
    if (fout.is_open())
    {
-      fout << length << " " << n_extr_bound << " " << n_extr_max << " " << nCTCF << " " << iTime << endl;
-      for (int i = 0; i < n_extr_bound; i++)
+      fout << length << " " << n_extr_bound << " " << pool.capacity << " " << nCTCF << " " << iTime << endl;
+      for (int w = 0; w < n_extr_bound; w++)
       {
-         for (int j = 0; j < 4; j++)
-            fout << extrList[i][j] << " ";
-         fout << endl;
+         int h = pool.handle[w];
+         fout << pool.site[0][h] << " " << pool.site[1][h] << " " << pool.arrival[0][h] << " " << pool.arrival[1][h] << " " << endl;
       }
-      for (int i = 0; i < length; i++)
-         if (ctcf[i] > 0)
-            fout << i << endl;
+      for (int i = barrier[1].Next(-1, 1); i < length; i = barrier[1].Next(i, 1)) // types 1 and 2
+         fout << i << endl;
    }
    else
    {
@@ -293,93 +506,315 @@ bool Extrusion::PrintState(string fileName)
 }
 
 /////////////////////////////////////////////
-// Read state from file
+// Read state from file: length, number of extruders and capacity, then
+// i j arrival_i arrival_j index for each extruder; or the binary format of WriteState
 /////////////////////////////////////////////
 bool Extrusion::ReadState(string fileName, bool debug = false)
 {
    cout << "Reading Initial state file..." << endl;
    cout << endl;
 
-   int k;
-
-   ifstream fin(fileName);
-
    // check if file is provided
    if ( fileName.empty() )
       {
          cout << "No State file provided" << endl;
          cout << endl;
    
-         return false;
+         return true;
       }
-   
-    // check if file exists 
-    if (fin.fail())
-    {
-       cout << "State file doesn't exist" << endl;
-       cout << endl;
-  
-       return false;
-    }
-   
-   // delete existing arrays
-   delete map;
-   delete[] extrList;
-   delete occupiedSites;
 
-   // read from file
-   if (fin.is_open())
+   TextFile fin;
+   if (!fin.Open(fileName))
    {
-      fin >> length;
-      fin >> n_extr_bound;
-      fin >> n_extr_max;
-
-      if (debug)
-         cerr << "Reading from file " + fileName + " " + to_string(n_extr_bound) + " extrusors." << endl;
-
-      map = AlloArrayInt(length); // rebuild arrays
-      extrList = new int[n_extr_max][5];
-      occupiedSites = new int[length];
-      for (int i = 0; i < length; i++)
-         occupiedSites[i] = 0;
+      exitError = fin.error;
+      return false;
+   }
 
-      for (int i = 0; i < n_extr_bound; i++) // read extruders
-         for (int j = 0; j < 5; j++)
+   // extruders as pairs of sites, pairs of arrivals and indices
+   int sizes[3]; // length, extruders, capacity
+   vector<int> sites, indices;
+   vector<int64_t> arrivals;
+   if (fin.Starts(STATE_MAGIC, 8))
+   {
+      fin.Close();
+      Checkpoint c;
+      bool ok = c.Read(fileName, STATE_MAGIC) && c.Get(sizes, sizeof(sizes)) && sizes[1] >= 0;
+      if (ok)
+      {
+         sites.resize(2 * sizes[1]);
+         arrivals.resize(2 * sizes[1]);
+         indices.resize(sizes[1]);
+         ok = c.Get(sites.data(), sites.size() * sizeof(int)) && c.Get(arrivals.data(), arrivals.size() * sizeof(int64_t)) &&
+              c.Get(indices.data(), indices.size() * sizeof(int));
+      }
+      if (!ok)
+      {
+         exitError = c.error;
+         return false;
+      }
+   }
+   else
+   {
+      if (!fin.Int(sizes[0]) || !fin.Int(sizes[1]) || !fin.Int(sizes[2]))
+      {
+         exitError = fin.error;
+         return false;
+      }
+      if (sizes[1] < 0)
+      {
+         exitError = fin.Where() + ": negative number of extruders";
+         return false;
+      }
+      sites.resize(2 * sizes[1]);
+      arrivals.resize(2 * sizes[1]);
+      indices.resize(sizes[1]);
+      for (int k = 0; k < sizes[1]; k++)
+         if (!fin.Int(sites[2 * k]) || !fin.Int(sites[2 * k + 1]) || !fin.Int64(arrivals[2 * k]) ||
+             !fin.Int64(arrivals[2 * k + 1]) || !fin.Int(indices[k]))
          {
-            fin >> extrList[i][j];
-            if ( extrList[i][4] > cnt_extr ){ cnt_extr = extrList[i][4] + 1; } // update extruder ID counter
+            exitError = fin.error;
+            return false;
          }
    }
-   else
+   if (sizes[0] != length)
    {
-      exitError = "Cannot open state file " + fileName;
+      exitError = fileName + " is for a chain of " + to_string(sizes[0]) + " sites, not " + to_string(length);
       return false;
    }
+   for (int k = 0; k < 2 * sizes[1]; k++)
+      if (sites[k] < 0 || sites[k] >= length)
+      {
+         exitError = fileName + ": site of extruder " + to_string(k / 2 + 1) + " out of range, i = " + to_string(sites[k]);
+         return false;
+      }
+   for (int k = 0; k < sizes[1]; k++)
+      if (sites[2 * k] / chainLength != sites[2 * k + 1] / chainLength)
+      {
+         exitError = fileName + ": extruder " + to_string(k + 1) + " joins two chains, sites " + to_string(sites[2 * k]) +
+                     " and " + to_string(sites[2 * k + 1]);
+         return false;
+      }
 
-   // reset all arrays
-   for (int i = 0; i < length; i++)
-      for (int j = 0; j < length; j++)
-         map[i][j] = 0;
+   // delete existing arrays
+   map.Clear();
+   delete[] legPrev;
+   delete[] legNext;
+   delete[] legStatus;
+   delete[] chRate;
+   delete[] legSetPos;
+   for (int status = 1; status < 3; status++)
+      delete[] legSet[status];
+
+   int n_read = sizes[1];
+   n_extr_max = sizes[2];
+   if (debug)
+      cerr << "Reading from file " + fileName + " " + to_string(n_read) + " extrusors." << endl;
+
+   pool.Clear(max(n_extr_max, n_read));
+   n_extr_bound = 0;
+   occupied.Resize(length);
+   siteLegs.Clear();
+   AlloLegs(0);
+
+   for (int k = 0; k < n_read; k++)
+   {
+      int i = sites[2 * k], j = sites[2 * k + 1], idx = indices[k];
+      int64_t iTimeI = arrivals[2 * k], iTimeJ = arrivals[2 * k + 1];
+      if ( idx > cnt_extr ){ cnt_extr = idx + 1; } // update extruder ID counter
+      if (j < i) // keep i<j
+      {
+         swap(i, j);
+         swap(iTimeI, iTimeJ);
+      }
+      int h = pool.Add(i, j, iTimeI, iTimeJ, idx);
+      n_extr_bound++;
+      map.Increment(i, j);
+      LinkLeg(h, 0);
+      LinkLeg(h, 1);
+   }
 
    // fill the arrays
-   for (int k = 0; k < n_extr_bound; k++)
+   for (int w = 0; w < n_extr_bound; w++)
    {
-      int i = extrList[k][0];
-      int j = extrList[k][1];
-      map[i][j]++;
-      map[j][i]++;
-      occupiedSites[i]++;
-      occupiedSites[j]++;
+      int h = pool.handle[w];
+      UpdateLegStatus(h, 0);
+      UpdateLegStatus(h, 1);
+      SetChannelRate(1 + 3 * h, k_unbinding);
    }
+   SetChannelRate(0, BindingRate());
 
    if (debug)
       cerr << "Read with success." << endl;
 
-   fin.close();
+   return true;
+}
+
+/////////////////////////////////////////////
+// Write the bound extruders in binary, read back by ReadState without parsing
+/////////////////////////////////////////////
+bool Extrusion::WriteState(string fileName)
+{
+   Checkpoint c;
+   int sizes[3] = {length, n_extr_bound, pool.capacity};
+   vector<int> sites(2 * n_extr_bound), indices(n_extr_bound);
+   vector<int64_t> arrivals(2 * n_extr_bound);
+
+   for (int w = 0; w < n_extr_bound; w++)
+   {
+      int h = pool.handle[w];
+      sites[2 * w] = pool.site[0][h];
+      sites[2 * w + 1] = pool.site[1][h];
+      arrivals[2 * w] = pool.arrival[0][h];
+      arrivals[2 * w + 1] = pool.arrival[1][h];
+      indices[w] = pool.index[h];
+   }
+   c.Put(sizes, sizeof(sizes));
+   c.Put(sites.data(), sites.size() * sizeof(int));
+   c.Put(arrivals.data(), arrivals.size() * sizeof(int64_t));
+   c.Put(indices.data(), indices.size() * sizeof(int));
+   if (!c.Write(fileName, STATE_MAGIC))
+   {
+      exitError = c.error;
+      return false;
+   }
 
    return true;
 }
 
+/////////////////////////////////////////////
+// Whole state of the kinetics, with the arrays kept up to date at each
+// event as they are (order of the sets of legs, propensities summed
+// step by step), so that a restored run draws the same events
+/////////////////////////////////////////////
+void Extrusion::Save(Checkpoint &c)
+{
+   int flags[4] = {length, chainLength, next_reaction, allow_overcome};
+   double rates[4] = {k_binding, k_unbinding, k_step, k_cross_ctcf};
+   int n_legs = 2 * pool.capacity;
+
+   c.Put(flags, sizeof(flags));
+   c.Put(rates, sizeof(rates));
+   c.Put(&n_extr_tot, sizeof(int));
+   c.Put(&iTime, sizeof(int64_t));
+   c.Put(&cnt_extr, sizeof(int));
+   c.Put(&n_extr_bound, sizeof(int));
+   c.Put(n_events, sizeof(n_events));
+   c.Put(&simTime, sizeof(double));
+   c.Put(rng.s, sizeof(rng.s));
+   c.Put(propensities, sizeof(propensities));
+   c.Put(&nCTCF, sizeof(int));
+   barrier[0].Save(c);
+   barrier[1].Save(c);
+   occupied.Save(c);
+   pool.Save(c);
+
+   siteLegs.Save(c);
+   c.Put(legPrev, n_legs * sizeof(int));
+   c.Put(legNext, n_legs * sizeof(int));
+   c.Put(legStatus, n_legs * sizeof(int));
+   c.Put(legSetPos, n_legs * sizeof(int));
+   c.Put(legSetSize, sizeof(legSetSize));
+   for (int status = 1; status < 3; status++)
+      c.Put(legSet[status], n_legs * sizeof(int));
+
+   if (next_reaction)
+   {
+      c.Put(chRate, (1 + 3 * pool.capacity) * sizeof(double));
+      queue.Save(c);
+   }
+}
+
+/////////////////////////////////////////////
+// State saved by Save, with the same length, engine, rates and policies
+/////////////////////////////////////////////
+bool Extrusion::Restore(Checkpoint &c)
+{
+   int flags[4], n_tot;
+   double rates[4];
+
+   if (!c.Get(flags, sizeof(flags)) || !c.Get(rates, sizeof(rates)) || !c.Get(&n_tot, sizeof(int)))
+   {
+      exitError = c.error;
+      return false;
+   }
+   if (flags[0] != length || flags[1] != chainLength || flags[2] != next_reaction || flags[3] != allow_overcome || n_tot != n_extr_tot ||
+       rates[0] != k_binding || rates[1] != k_unbinding || rates[2] != k_step || rates[3] != k_cross_ctcf)
+   {
+      exitError = "Checkpoint was written with another length, n_chains, engine, allow_overcome, n_extr_tot or rates";
+      return false;
+   }
+
+   // the CTCF sites come from the checkpoint, not from another engine
+   if (!ownCTCF)
+   {
+      barrier = new BitPlane[2];
+      ownCTCF = true;
+   }
+
+   bool ok = c.Get(&iTime, sizeof(int64_t)) && c.Get(&cnt_extr, sizeof(int)) && c.Get(&n_extr_bound, sizeof(int)) &&
+             c.Get(n_events, sizeof(n_events)) && c.Get(&simTime, sizeof(double)) && c.Get(rng.s, sizeof(rng.s)) &&
+             c.Get(propensities, sizeof(propensities)) && c.Get(&nCTCF, sizeof(int)) &&
+             barrier[0].Restore(c) && barrier[1].Restore(c) && occupied.Restore(c) && pool.Restore(c);
+   if (!ok)
+   {
+      exitError = c.error;
+      return false;
+   }
+
+   // arrays sized for the capacity of the restored pool
+   delete[] legPrev;
+   delete[] legNext;
+   delete[] legStatus;
+   delete[] chRate;
+   delete[] legSetPos;
+   for (int status = 1; status < 3; status++)
+      delete[] legSet[status];
+   AlloLegs(0);
+
+   int n_legs = 2 * pool.capacity;
+   ok = siteLegs.Restore(c) && c.Get(legPrev, n_legs * sizeof(int)) && c.Get(legNext, n_legs * sizeof(int)) &&
+        c.Get(legStatus, n_legs * sizeof(int)) && c.Get(legSetPos, n_legs * sizeof(int)) && c.Get(legSetSize, sizeof(legSetSize));
+   for (int status = 1; status < 3; status++)
+      ok = ok && c.Get(legSet[status], n_legs * sizeof(int));
+   if (next_reaction)
+      ok = ok && c.Get(chRate, (1 + 3 * pool.capacity) * sizeof(double)) && queue.Restore(c);
+   if (!ok)
+   {
+      exitError = c.error;
+      return false;
+   }
+
+   // the layout of the link map does not change the events, it is rebuilt
+   map.Clear();
+   for (int w = 0; w < n_extr_bound; w++)
+      map.Increment(Left(w), Right(w));
+
+   return true;
+}
+
+/////////////////////////////////////////////
+// Bound extruders as triplets (unique index, i, j), and if asked
+// the event counts at the last move of i and j as pairs
+/////////////////////////////////////////////
+void Extrusion::Snapshot(vector<int> &extruders, vector<int64_t> *arrivals)
+{
+   extruders.resize(3 * n_extr_bound);
+   if (arrivals)
+      arrivals->resize(2 * n_extr_bound);
+   for (int w = 0; w < n_extr_bound; w++)
+   {
+      int h = pool.handle[w];
+      extruders[3 * w] = pool.index[h];
+      extruders[3 * w + 1] = pool.site[0][h];
+      extruders[3 * w + 2] = pool.site[1][h];
+      if (arrivals)
+      {
+         (*arrivals)[2 * w] = pool.arrival[0][h];
+         (*arrivals)[2 * w + 1] = pool.arrival[1][h];
+      }
+   }
+}
+
 /////////////////////////////////////////////
 // Print extrusor map
 /////////////////////////////////////////////
@@ -400,19 +835,38 @@ bool Extrusion::PrintMap(string fileName = "", bool asList = false, bool onlyExi
       for (int i = 0; i < length; i++)
       {
          for (int j = 0; j < length; j++)
-            fout << setw(3) << map[i][j];
+            fout << setw(3) << map.Get(i, j);
          fout << endl;
       }
    }
    else
-      for (int i = 0; i < length; i++)
-         for (int j = i + 1; j < length; j++)
-            if (!onlyExist || map[i][j] > 0)
+   {
+      // existing links sorted by i and then j
+      vector<int> li, lj, ln;
+      map.List(li, lj, ln);
+
+      if (onlyExist)
+         for (size_t k = 0; k < li.size(); k++)
+         {
+            fout << setw(6) << li[k];
+            fout << setw(6) << lj[k];
+            fout << setw(3) << ln[k] << endl;
+         }
+      else
+      {
+         size_t k = 0;
+         for (int i = 0; i < length; i++)
+            for (int j = i + 1; j < length; j++)
             {
+               int n = 0;
+               if (k < li.size() && li[k] == i && lj[k] == j)
+                  n = ln[k++];
                fout << setw(6) << i;
                fout << setw(6) << j;
-               fout << setw(3) << map[i][j] << endl;
+               fout << setw(3) << n << endl;
             }
+      }
+   }
 
    if (fileName == "")
       tmp.close();
@@ -445,43 +899,37 @@ void Extrusion::CatchError(bool ok)
 /////////////////////////////////////////////
 
 /////////////////////////////////////////////
-// Allocate n*n matrix
+// Create an extruder at sites i, j, growing the arrays of legs and channels if needed
 /////////////////////////////////////////////
-int **Extrusion::AlloArrayInt(int n)
+bool Extrusion::AddExtruder(int i, int j, int64_t iTimeI, int64_t iTimeJ, int index)
 {
-   int **x = new int *[n];
-   for (int i = 0; i < n; i++)
-   {
-      x[i] = new int[n];
-      for (int j = 0; j < n; j++)
-         x[i][j] = 0;
-   }
-   return x;
+   return (this->*kernel[0].addExtruder)(i, j, iTimeI, iTimeJ, index);
 }
 
-/////////////////////////////////////////////
-// Create an extruder at sites i, j
-/////////////////////////////////////////////
-bool Extrusion::AddExtruder(int i, int j, int iTimeI, int iTimeJ, int index)
+template <int F>
+bool Extrusion::AddExtruder(int i, int j, int64_t iTimeI, int64_t iTimeJ, int index)
 {
-   map[i][j]++;
-   map[j][i]++;
-   extrList[n_extr_bound][0] = i;
-   extrList[n_extr_bound][1] = j;
-   extrList[n_extr_bound][2] = iTimeI;
-   extrList[n_extr_bound][3] = iTimeJ;
-   extrList[n_extr_bound][4] = index;
-   occupiedSites[i]++;
-   occupiedSites[j]++;
+   int n_links = map.Increment(i, j);
+   int capacity = pool.capacity;
+   int h = pool.Add(i, j, iTimeI, iTimeJ, index);
+   if (pool.capacity != capacity)
+      AlloLegs(capacity);
+
+   LinkLeg(h, 0);
+   LinkLeg(h, 1);
+   UpdateLegStatus<F>(h, 0);
+   UpdateLegStatus<F>(h, 1);
+   SetChannelRate(1 + 3 * h, k_unbinding);
    n_extr_bound++;
-   if (n_extr_bound >= n_extr_max)
+   SetChannelRate(0, BindingRate());
+   if (!(F & OVERCOME)) // the new legs may block the ones already there
    {
-      exitError = "nEntrMax too small.";
-      CatchError(false);
+      RefreshSite<F>(i);
+      RefreshSite<F>(j);
    }
 
    // tell lammps to add a link if there were none
-   if (map[i][j] == 1)
+   if (n_links == 1)
    {
       add_link = true;
       add_link_i = i;
@@ -492,33 +940,43 @@ bool Extrusion::AddExtruder(int i, int j, int iTimeI, int iTimeJ, int index)
 }
 
 /////////////////////////////////////////////
-// Destroy an extruder at sites i, j
+// Destroy extruder h
 /////////////////////////////////////////////
-bool Extrusion::RemoveExtruder(int i, int j, int iTimeI, int iTimeJ)
+bool Extrusion::RemoveExtruder(int h)
 {
-   if (map[i][j] == 0)
+   return (this->*kernel[0].removeExtruder)(h);
+}
+
+template <int F>
+bool Extrusion::RemoveExtruder(int h)
+{
+   if (h < 0 || h >= pool.capacity || !pool.Bound(h))
    {
-      exitError = "Trying to remove extruder that is not there (i=" + to_string(i) + ", j=" + to_string(j) + ")";
+      exitError = "Trying to remove extruder that is not there (h=" + to_string(h) + ")";
       return false;
    }
 
-   map[i][j]--;
-   map[j][i]--;
-   occupiedSites[i]--;
-   occupiedSites[j]--;
+   int i = pool.site[0][h];
+   int j = pool.site[1][h];
+   int n_links = map.Decrement(i, j);
 
-   for (int n = 0; n < n_extr_bound; n++)
-      if ((extrList[n][0] == i && extrList[n][1] == j && extrList[n][2] == iTimeI && extrList[n][3] == iTimeJ) || (extrList[n][0] == j && extrList[n][1] == i && extrList[n][2] == iTimeI && extrList[n][3] == iTimeJ))
-      {
-         for (int k = 0; k < 5; k++)
-            extrList[n][k] = extrList[n_extr_bound - 1][k];
-         break;
-      }
+   ClearLegStatus(h, 0);
+   ClearLegStatus(h, 1);
+   UnlinkLeg(h, 0);
+   UnlinkLeg(h, 1);
+   if (!(F & OVERCOME)) // legs left behind may be free to step
+   {
+      RefreshSite<F>(i);
+      RefreshSite<F>(j);
+   }
+   SetChannelRate(1 + 3 * h, 0.);
+   pool.Remove(h);
 
    n_extr_bound--;
+   SetChannelRate(0, BindingRate());
 
    // tell lammps to remove a link if there was only one left
-   if (map[i][j] == 0)
+   if (n_links == 0)
    {
       delete_link = true;
       delete_link_i = i;
@@ -529,25 +987,234 @@ bool Extrusion::RemoveExtruder(int i, int j, int iTimeI, int iTimeJ)
 }
 
 /////////////////////////////////////////////
-// Random number in [0,n)
+// Size the arrays of legs and reaction channels to the capacity of the pool,
+// keeping the first 2*old_capacity legs and 1+3*old_capacity channels
+/////////////////////////////////////////////
+void Extrusion::AlloLegs(int old_capacity)
+{
+   int n_legs = 2 * pool.capacity, n_old = 2 * old_capacity;
+   int *arrays[4] = {legPrev, legNext, legStatus, legSetPos};
+
+   for (int a = 0; a < 4; a++)
+   {
+      int *grown = new int[n_legs];
+      for (int leg = 0; leg < n_old; leg++)
+         grown[leg] = arrays[a][leg];
+      if (old_capacity > 0)
+         delete[] arrays[a];
+      arrays[a] = grown;
+   }
+   legPrev = arrays[0];
+   legNext = arrays[1];
+   legStatus = arrays[2];
+   legSetPos = arrays[3];
+   for (int leg = n_old; leg < n_legs; leg++)
+      legStatus[leg] = 0;
+
+   for (int status = 1; status < 3; status++)
+   {
+      int *grown = new int[n_legs];
+      for (int k = 0; k < n_old; k++)
+         grown[k] = legSet[status][k];
+      if (old_capacity > 0)
+         delete[] legSet[status];
+      else
+         legSetSize[status] = 0;
+      legSet[status] = grown;
+   }
+
+   // reaction channels of the next-reaction method
+   int n_channels = next_reaction ? 1 + 3 * pool.capacity : 0;
+   int n_old_channels = (next_reaction && old_capacity > 0) ? 1 + 3 * old_capacity : 0;
+   double *grown = new double[n_channels];
+   for (int ch = 0; ch < n_channels; ch++)
+      grown[ch] = (ch < n_old_channels) ? chRate[ch] : 0.;
+   if (old_capacity > 0)
+      delete[] chRate;
+   chRate = grown;
+   if (old_capacity > 0)
+      queue.Grow(n_channels);
+   else
+      queue.Resize(n_channels);
+}
+
+/////////////////////////////////////////////
+// Insert leg side of extruder h in the list of its site, keeping it sorted by arrival time
+/////////////////////////////////////////////
+void Extrusion::LinkLeg(int h, int side)
+{
+   int leg = 2 * h + side;
+   int s = pool.site[side][h];
+   int64_t t = pool.arrival[side][h];
+   SiteIndex::Legs *l = siteLegs.Insert(s);
+
+   // new arrivals are the latest, so this is O(1) except when reading a state
+   int prev = l->tail[side];
+   while (prev >= 0 && pool.arrival[side][prev / 2] > t)
+      prev = legPrev[prev];
+
+   int next = (prev >= 0) ? legNext[prev] : l->head[side];
+   legStatus[leg] = 0;
+   legPrev[leg] = prev;
+   legNext[leg] = next;
+   if (prev >= 0)
+      legNext[prev] = leg;
+   else
+      l->head[side] = leg;
+   if (next >= 0)
+      legPrev[next] = leg;
+   else
+      l->tail[side] = leg;
+   occupied.Set(s);
+}
+
+/////////////////////////////////////////////
+// Remove leg side of extruder h from the list of its site
+/////////////////////////////////////////////
+void Extrusion::UnlinkLeg(int h, int side)
+{
+   int leg = 2 * h + side;
+   int s = pool.site[side][h];
+   SiteIndex::Legs *l = siteLegs.Find(s);
+
+   if (legPrev[leg] >= 0)
+      legNext[legPrev[leg]] = legNext[leg];
+   else
+      l->head[side] = legNext[leg];
+   if (legNext[leg] >= 0)
+      legPrev[legNext[leg]] = legPrev[leg];
+   else
+      l->tail[side] = legPrev[leg];
+   if (l->head[0] < 0 && l->head[1] < 0)
+   {
+      siteLegs.Erase(s);
+      occupied.Clear(s);
+   }
+}
+
+/////////////////////////////////////////////
+// Set which reaction (if any) leg side of extruder h can undergo, updating the sets of legs
+/////////////////////////////////////////////
+void Extrusion::UpdateLegStatus(int h, int side)
+{
+   (this->*kernel[0].updateLegStatus)(h, side);
+}
+
+template <int F>
+void Extrusion::UpdateLegStatus(int h, int side)
+{
+   int leg = 2 * h + side;
+   int status = 0;
+
+   if (CheckStepOk<F>(h, side, false))
+      status = 1;
+   else if ((F & CROSS) && CheckStepOk<F>(h, side, true))
+      status = 2;
+
+   if (status == legStatus[leg])
+      return;
+
+   ClearLegStatus(h, side);
+   legStatus[leg] = status;
+   if (status != 0)
+   {
+      legSetPos[leg] = legSetSize[status];
+      legSet[status][legSetSize[status]++] = leg;
+   }
+   SetChannelRate(2 + 3 * h + side, LegRate(leg));
+}
+
+/////////////////////////////////////////////
+// Mark leg side of extruder h as blocked, removing it from its set
+/////////////////////////////////////////////
+void Extrusion::ClearLegStatus(int h, int side)
+{
+   int leg = 2 * h + side;
+   int status = legStatus[leg];
+
+   if (status != 0)
+   {
+      int last = legSet[status][--legSetSize[status]];
+      legSet[status][legSetPos[leg]] = last;
+      legSetPos[last] = legSetPos[leg];
+   }
+   legStatus[leg] = 0;
+   SetChannelRate(2 + 3 * h + side, 0.);
+}
+
+/////////////////////////////////////////////
+// Update the legs of site s whose blocking may have changed.
+// Only the earliest arrivals can be free, the others are already blocked.
 /////////////////////////////////////////////
-int Extrusion::iRand(int n, int seed)
+template <int F>
+void Extrusion::RefreshSite(int s)
 {
-   static std::mt19937 gen(seed);
-   std::uniform_int_distribution<int> distr(0, n - 1); // define the distribution
+   SiteIndex::Legs *l = siteLegs.Find(s);
+   if (l == NULL)
+      return;
+
+   for (int side = 0; side < 2; side++)
+   {
+      int leg = l->head[side];
+      if (leg < 0)
+         continue;
+
+      int64_t t = pool.arrival[side][leg / 2];
+      while (leg >= 0 && (pool.arrival[side][leg / 2] == t || legStatus[leg] != 0))
+      {
+         UpdateLegStatus<F>(leg / 2, side);
+         leg = legNext[leg];
+      }
+   }
+}
 
-   return distr(gen); // generate and return the random number
+/////////////////////////////////////////////
+// Change the rate of a channel, rescaling its putative time (Gibson-Bruck)
+/////////////////////////////////////////////
+void Extrusion::SetChannelRate(int ch, double rate)
+{
+   if (!next_reaction)
+      return;
+
+   double old = chRate[ch];
+   if (rate == old)
+      return;
+
+   chRate[ch] = rate;
+   if (rate <= 0.)
+      queue.Update(ch, HUGE_VAL);
+   else if (old <= 0.)
+      queue.Update(ch, simTime + log(1. / DRand()) / rate);
+   else
+      queue.Update(ch, simTime + old / rate * (queue.Time(ch) - simTime));
 }
 
 /////////////////////////////////////////////
-// Random number double in [0,1)
+// Rate of binding of a new extruder
 /////////////////////////////////////////////
-double Extrusion::DRand(int seed)
+double Extrusion::BindingRate(void)
 {
-   static std::mt19937 gen(seed);                                 // seed the generator
-   std::uniform_real_distribution<double> distr(0.0, 1.0); // define the distribution
+   int n_extr_free;
 
-   return distr(gen); // generate and return the random number
+   if (n_extr_tot > 0)
+      n_extr_free = n_extr_tot - n_extr_bound;
+   else
+      n_extr_free = 1;
+
+   return k_binding * n_extr_free;
+}
+
+/////////////////////////////////////////////
+// Rate of stepping of a leg, according to its status
+/////////////////////////////////////////////
+double Extrusion::LegRate(int leg)
+{
+   if (legStatus[leg] == 1)
+      return k_step;
+   else if (legStatus[leg] == 2)
+      return k_cross_ctcf;
+
+   return 0.;
 }
 
 /////////////////////////////////////////////
@@ -563,48 +1230,38 @@ bool Extrusion::LogicalXOR(bool a, bool b)
 /////////////////////////////////////////////
 bool Extrusion::CalculatePropensities(bool debug = false)
 {
-   int n_extr_free, n_steppable = 0, n_cross_ctcf = 0;
+   return (this->*kernel[debug].calculatePropensities)();
+}
 
+template <int F>
+bool Extrusion::CalculatePropensities(void)
+{
    for (int i = 0; i < NREACT + 1; i++)
       propensities[i] = 0.;
 
    // 1 - random binding
-   if (n_extr_tot > 0)
-      n_extr_free = n_extr_tot - n_extr_bound;
-   else
-      n_extr_free = 1;
-   propensities[1] = k_binding * n_extr_free;
+   propensities[1] = BindingRate();
 
    // 2 - random unbinding
    propensities[2] = k_unbinding * n_extr_bound;
 
    // 3 - stepping (no ctcf)
-   if (k_step > 0)
-   {
-      for (int w = 0; w < n_extr_bound; w++)
-         for (int dir = 0; dir < 2; dir++)
-            if (CheckStepOk(w, dir, false, debug))
-               n_steppable += 1;
-      propensities[3] = k_step * n_steppable;
-   }
+   propensities[3] = k_step * legSetSize[1];
 
    // 4 - crossing ctcf
-   if (k_cross_ctcf > 0)
-   {
-      for (int w = 0; w < n_extr_bound; w++)
-         for (int dir = 0; dir < 2; dir++)
-            if (CheckStepOk(w, dir, true, debug))
-               n_cross_ctcf += 1;
-      propensities[4] = k_cross_ctcf * n_cross_ctcf;
-   }
+   propensities[4] = k_cross_ctcf * legSetSize[2];
 
-   for (int i = 0; i < NREACT; i++)
+   for (int i = 1; i <= NREACT; i++)
       propensities[0] += propensities[i];
 
-   if (debug)
+   // compare the incremental counts with a full recalculation
+   if (F & DEBUG)
+      CatchError(CheckPropensities());
+
+   if (F & DEBUG)
    {
       cerr << "Propensities:" << endl;
-      for (int i = 1; i < NREACT; i++)
+      for (int i = 1; i <= NREACT; i++)
          cerr << "a[" + to_string(i) + "]=" + to_string(propensities[i]) + "  - " + reaction_name[i] << endl;
       cerr << "=> a[0]=" + to_string(propensities[0]) << endl;
    }
@@ -613,68 +1270,104 @@ bool Extrusion::CalculatePropensities(bool debug = false)
 }
 
 /////////////////////////////////////////////
-// check if suggested step clashes with another extrusor and if is on ctcf
+// check the incremental status of the legs against a full recalculation
 /////////////////////////////////////////////
-bool Extrusion::CheckStepOk(int w, int dir, bool ctcf_cross, bool debug = false)
+bool Extrusion::CheckPropensities(void)
 {
-   int i = extrList[w][0];
-   int j = extrList[w][1];
-   int iTimeI = extrList[w][2];
-   int iTimeJ = extrList[w][3];
-
-   // if (debug) cerr << " testing extruder step from "+to_string(i)+"-"+to_string(j)+" (w="+to_string(w)+
-   //                         ") direction="+to_string(dir) << endl;
+   int n_steppable_full = 0, n_cross_ctcf_full = 0;
 
-   // check if it is allowed overcoming another extrusor
-   if (!allow_overcome)
-   {
-      if (dir == 0)
+   for (int w = 0; w < n_extr_bound; w++)
+      for (int dir = 0; dir < 2; dir++)
       {
-         for (int k = 0; k < n_extr_bound; k++) // if there is an extrusor in i from more time, skip.
-            if ((k != w && extrList[k][0] == i && extrList[k][2] < iTimeI) ||
-                (k != w && extrList[k][1] == i))
-            {
-               if (debug)
-                  cerr << "  step is stopped by overlap with w=" + to_string(k) + " (" +
-                              to_string(extrList[k][0]) + "-" + to_string(extrList[k][1]) + ")"
-                       << endl;
-               return false;
-            }
+         int h = pool.handle[w];
+         int leg = 2 * h + dir;
+         int status = 0;
+         if (CheckStepOk(h, dir, false))
+         {
+            status = 1;
+            n_steppable_full++;
+         }
+         if (k_cross_ctcf > 0. && CheckStepOk(h, dir, true))
+         {
+            status = 2;
+            n_cross_ctcf_full++;
+         }
+         if (status != legStatus[leg] || (status != 0 && legSet[status][legSetPos[leg]] != leg))
+         {
+            exitError = "Incremental propensities are wrong: leg " + to_string(dir) + " of extruder h=" + to_string(h) +
+                        " has status " + to_string(legStatus[leg]) + " instead of " + to_string(status);
+            return false;
+         }
+         if (next_reaction && chRate[2 + 3 * h + dir] != LegRate(leg))
+         {
+            exitError = "Wrong rate of channel of leg " + to_string(dir) + " of extruder h=" + to_string(h);
+            return false;
+         }
       }
-      else if (dir == 1)
+
+   if (next_reaction)
+      for (int ch = 0; ch < 1 + 3 * pool.capacity; ch++)
       {
-         for (int k = 0; k < n_extr_bound; k++) // if there is an extrusor in j from more time, skip.
-            if ((k != w && extrList[k][0] == j) ||
-                (k != w && extrList[k][1] == j && extrList[k][3] < iTimeJ))
-            {
-               if (debug)
-                  cerr << "  step is stopped by overlap with w=" + to_string(k) + " (" +
-                              to_string(extrList[k][0]) + "-" + to_string(extrList[k][1]) + ")"
-                       << endl;
-               return false;
-            }
+         int h = (ch - 1) / 3;
+         int k = (ch - 1) % 3; // 0=unbinding, 1=step of i, 2=step of j
+         double rate = 0.;
+         if (ch == 0)
+            rate = BindingRate();
+         else if (!pool.Bound(h))
+            rate = 0.;
+         else if (k == 0)
+            rate = k_unbinding;
+         else
+            rate = LegRate(2 * h + k - 1);
+         if (chRate[ch] != rate || (rate <= 0. && queue.Time(ch) != HUGE_VAL))
+         {
+            exitError = "Wrong rate of channel " + to_string(ch);
+            return false;
+         }
       }
-   }
 
-   // check if meeting ctcf condition of the function argument
-   // of i (left)
-   if (dir == 0)
+   if (n_steppable_full != legSetSize[1] || n_cross_ctcf_full != legSetSize[2])
    {
-      if (ctcf_cross && (ctcf[i - 1] == -1 || ctcf[i - 1] == 2))
-         return true;
-      else if (!ctcf_cross && (ctcf[i - 1] == 0 || ctcf[i - 1] == 1))
-         return true;
+      exitError = "Incremental propensities are wrong: steppable " + to_string(legSetSize[1]) + " instead of " +
+                  to_string(n_steppable_full) + ", ctcf crossing " + to_string(legSetSize[2]) + " instead of " +
+                  to_string(n_cross_ctcf_full);
+      return false;
    }
-   // of j (right)
-   else if (dir == 1)
+
+   return true;
+}
+
+/////////////////////////////////////////////
+// check if suggested step clashes with another extrusor and if is on ctcf
+/////////////////////////////////////////////
+bool Extrusion::CheckStepOk(int h, int dir, bool ctcf_cross)
+{
+   return (this->*kernel[0].checkStepOk)(h, dir, ctcf_cross);
+}
+
+template <int F>
+bool Extrusion::CheckStepOk(int h, int dir, bool ctcf_cross)
+{
+   int s = pool.site[dir][h];
+
+   // check if it is allowed overcoming another extrusor:
+   // the leg is stopped by a leg of opposite direction on its site,
+   // or by a leg of the same direction that arrived there earlier
+   if (!(F & OVERCOME))
    {
-      if (ctcf_cross && (ctcf[j + 1] == 1 || ctcf[j + 1] == 2))
-         return true;
-      else if (!ctcf_cross && (ctcf[j + 1] == 0 || ctcf[j + 1] == -1))
-         return true;
+      SiteIndex::Legs *l = siteLegs.Find(s);
+      if (l->head[1 - dir] >= 0 || pool.arrival[dir][l->head[dir] / 2] < pool.arrival[dir][h])
+         return false;
    }
 
-   return false;
+   // check if meeting ctcf condition of the function argument: the next site
+   // of i (left) or j (right) must hold a barrier for that direction to cross it,
+   // and none to step (beyond the ends of the chain there is no ctcf, even if
+   // the next chain starts with one)
+   if (s % chainLength == (dir == 0 ? 0 : chainLength - 1))
+      return !ctcf_cross;
+   int next = (dir == 0) ? s - 1 : s + 1;
+   return barrier[dir].Get(next) == ctcf_cross;
 }
 
 /////////////////////////////////////////////
@@ -686,7 +1379,7 @@ int Extrusion::SelectReaction(void)
 
    r = propensities[0] * DRand();
 
-   for (int i = 1; i < NREACT; i++)
+   for (int i = 1; i <= NREACT; i++)
    {
       aSum += propensities[i];
       if (r < aSum)
@@ -700,7 +1393,8 @@ int Extrusion::SelectReaction(void)
 /////////////////////////////////////////////
 // Apply Gillespie reaction
 /////////////////////////////////////////////
-bool Extrusion::ApplyReaction(int r, bool debug = false)
+template <int F>
+bool Extrusion::ApplyReaction(int r)
 {
    bool ok;
 
@@ -708,29 +1402,79 @@ bool Extrusion::ApplyReaction(int r, bool debug = false)
    {
    case 1: // random binding
    {
-      ok = RandomBind(debug);
+      ok = RandomBind<F>();
       break;
    }
 
    case 2: // random unbinding
    {
-      ok = RandomUnbind(debug);
+      ok = RandomUnbind<F>();
       break;
    }
 
    case 3: // step far from ctcf
    {
-      ok = RandomStepForward(false, debug);
+      ok = RandomStepForward<F>(false);
       break;
    }
    case 4: // overcome ctcf
    {
-      ok = RandomStepForward(true, debug);
+      ok = RandomStepForward<F>(true);
       break;
    }
    }
 
    if (ok)
+   {
       iTime++;
+      n_events[r]++;
+   }
+   return ok;
+}
+
+/////////////////////////////////////////////
+// Apply the reaction of the channel with the earliest putative time
+// (next-reaction method, Gibson and Bruck)
+/////////////////////////////////////////////
+template <int F>
+bool Extrusion::FireChannel(void)
+{
+   bool ok;
+   int r;
+   int ch = queue.Top();
+
+   simTime = queue.TopTime();
+
+   // the fired channel gets a new time once the reaction is applied
+   chRate[ch] = 0.;
+   queue.Update(ch, HUGE_VAL);
+
+   if (ch == 0)
+   {
+      r = 1;
+      ok = RandomBind<F>();
+   }
+   else if ((ch - 1) % 3 == 0)
+   {
+      r = 2;
+      ok = Unbind<F>((ch - 1) / 3);
+   }
+   else
+   {
+      int h = (ch - 1) / 3;
+      int leg = 2 * h + (ch - 2 - 3 * h);
+      r = (legStatus[leg] == 2) ? 4 : 3;
+      ok = StepLeg<F>(leg);
+   }
+   if (F & DEBUG)
+      cerr << "Fired channel " + to_string(ch) + "  : " + reaction_name[r] << endl;
+
+   SetChannelRate(0, BindingRate());
+
+   if (ok)
+   {
+      iTime++;
+      n_events[r]++;
+   }
    return ok;
 }
@@ -7,20 +7,36 @@
 #include <ctime>
 #include <cmath>
 #include <iomanip>
+#include <random>
+#include <vector>
 
 #ifndef HPARAMETERS
 #define HPARAMETERS
 #include "parameters.h"
 #endif
 
-#define LARGE 999999
+#ifndef EXTRUSION_H
+#define EXTRUSION_H
+
+#include "linkmap.h"
+#include "eventqueue.h"
+#include "extruderpool.h"
+#include "bitplane.h"
+#include "siteindex.h"
+#include "rng.h"
+#include "checkpoint.h"
+#include "textfile.h"
+
 #define SMALL 1E-15
 #define NREACT 4
+#define CTCF_MAGIC "LECTCF1"   // binary CTCF file (WriteCTCF)
+#define STATE_MAGIC "LESTAT1"  // binary state file (WriteState)
 
 using namespace std;
 
 class Extrusion
 {
+  friend class Bench; // microbenchmarks of the private steps
 
 public:
   // input
@@ -29,6 +45,7 @@ public:
   double k_step;
   double k_cross_ctcf;
   bool allow_overcome;
+  bool next_reaction; // Gibson-Bruck next-reaction method instead of the direct method
   int n_extr_tot; // set to -1 to ignore
   int seed;
 
@@ -42,41 +59,111 @@ public:
   int delete_link_j;
   int n_extr_bound;   // how many extruders bound
   int cnt_extr;       // unique progressive index of extruders
-  int (*extrList)[5]; // 0=i, 1=j, 2=time last move i, 3=time last move j, 4=unique index
+  long n_events[NREACT + 1]; // events of each reaction since the start
+  string reaction_name[NREACT + 1];
   string exitError;
 
   // functions
   Extrusion(Parameters);
+  ~Extrusion();
   bool Event(bool debug);
+  bool DrawTime(bool debug);
+  bool ApplyEvent(bool debug);
   bool ReadCTCF(string fileName);
+  bool WriteCTCF(string fileName);
+  bool ShareCTCF(Extrusion &source);
   bool PrintState(string fileName);
   bool ReadState(string fileName, bool debug);
+  bool WriteState(string fileName);
+  void Save(Checkpoint &c);
+  bool Restore(Checkpoint &c);
   bool PrintMap(string fileName, bool asList, bool onlyExist);
   void CatchError(bool ok);
 
+  // bound extruders by position w in [0,n_extr_bound), which changes when others unbind
+  int Left(int w) { return pool.site[0][pool.handle[w]]; }
+  int Right(int w) { return pool.site[1][pool.handle[w]]; }
+  int Index(int w) { return pool.index[pool.handle[w]]; }
+  bool Occupied(int s) { return occupied.Get(s); }
+  long OccupiedSites(void) { return occupied.Count(); }
+  void Snapshot(vector<int> &extruders, vector<int64_t> *arrivals = NULL);
+
 private:
-  int iTime;
+  int64_t iTime; // events since the start, orders the arrivals of legs on a site
   int length;
-  int *ctcf;
+  int chainLength;   // sites of each chain: the extruders do not bind nor step from one chain to the next
+  BitPlane *barrier; // CTCF sites stopping a leg moving left (0: types -1, 2) or right (1: types 1, 2)
+  bool ownCTCF;      // false if barrier belongs to another engine
   int nCTCF;
-  int *occupiedSites;
-  int n_extr_max;
+  ExtruderPool pool; // bound extruders, by handle h
+  BitPlane occupied; // sites with at least one leg
+  SiteIndex siteLegs; // first and last left (0) and right (1) legs of the occupied sites
+  int *legPrev;     // previous leg on the same site and side
+  int *legNext;     // next leg on the same site and side
+  int *legStatus;   // 0=blocked, 1=can step (reaction 3), 2=can cross ctcf (reaction 4, only if k_cross_ctcf > 0)
+  int *legSet[3];   // legs with status 1 and 2, in no particular order
+  int legSetSize[3];
+  int *legSetPos;   // position of a leg in the set of its status
+  int n_extr_max; // initial capacity of the pool
   double propensities[NREACT + 1];
-  int **map; // how many extruders between i and j
-  string reaction_name[NREACT + 1];
+  LinkMap map; // how many extruders between i and j
+  double simTime;   // time of the last event (next-reaction method)
+  EventQueue queue; // putative time of each channel: 0=binding, 1+3*h=unbinding of h, 2+3*h+side=step of a leg
+  double *chRate;   // current rate of each channel
+  Rng rng;          // random stream of this engine
+
+  // run-constant policies the kernels are compiled for: debug tracing and checks,
+  // allow_overcome, k_cross_ctcf > 0 (otherwise the legs at a CTCF site are blocked)
+  enum Policy { DEBUG = 1, OVERCOME = 2, CROSS = 4 };
+  struct Kernel
+  {
+    bool (Extrusion::*event)(void);
+    bool (Extrusion::*drawTime)(void);
+    bool (Extrusion::*applyEvent)(void);
+    bool (Extrusion::*calculatePropensities)(void);
+    bool (Extrusion::*addExtruder)(int, int, int64_t, int64_t, int);
+    bool (Extrusion::*removeExtruder)(int);
+    void (Extrusion::*updateLegStatus)(int, int);
+    bool (Extrusion::*checkStepOk)(int, int, bool);
+  };
+  Kernel kernel[2]; // instantiation for the policies of this engine, without and with debug
 
   // functions
-  int **AlloArrayInt(int n);
-  bool RandomBind(bool debug);
-  bool RandomUnbind(bool debug);
-  bool RandomStepForward(bool ctcf_cross, bool debug);
-  bool AddExtruder(int i, int j, int iTimeI, int iTimeJ, int index);
-  bool RemoveExtruder(int i, int j, int iTimeI, int iTimeJ);
-  int iRand(int n, int seed=42);
-  double DRand(int seed=42);
+  void SetKernels(void);
+  template <int F> void BindKernel(Kernel &k);
+  template <int F> bool Event(void);
+  template <int F> bool DrawTime(void);
+  template <int F> bool ApplyEvent(void);
+  template <int F> bool RandomBind(void);
+  template <int F> bool RandomUnbind(void);
+  template <int F> bool RandomStepForward(bool ctcf_cross);
+  template <int F> bool Unbind(int h);
+  template <int F> bool StepLeg(int leg);
+  bool AddExtruder(int i, int j, int64_t iTimeI, int64_t iTimeJ, int index);
+  template <int F> bool AddExtruder(int i, int j, int64_t iTimeI, int64_t iTimeJ, int index);
+  bool RemoveExtruder(int h);
+  template <int F> bool RemoveExtruder(int h);
+  void AlloLegs(int old_capacity);
+  void LinkLeg(int h, int side);
+  void UnlinkLeg(int h, int side);
+  void UpdateLegStatus(int h, int side);
+  template <int F> void UpdateLegStatus(int h, int side);
+  void ClearLegStatus(int h, int side);
+  template <int F> void RefreshSite(int s);
+  void SetChannelRate(int ch, double rate);
+  double BindingRate(void);
+  double LegRate(int leg);
+  int iRand(int n) { return rng.Int(n); }     // random number in [0,n)
+  double DRand(void) { return rng.Double(); } // random double in (0,1)
   bool LogicalXOR(bool a, bool b);
   bool CalculatePropensities(bool debug);
-  bool CheckStepOk(int w, int dir, bool ctcf_cross, bool debug);
+  template <int F> bool CalculatePropensities(void);
+  bool CheckPropensities(void);
+  bool CheckStepOk(int h, int dir, bool ctcf_cross);
+  template <int F> bool CheckStepOk(int h, int dir, bool ctcf_cross);
   int SelectReaction(void);
-  bool ApplyReaction(int r, bool debug);
+  template <int F> bool ApplyReaction(int r);
+  template <int F> bool FireChannel(void);
 };
+
+#endif
@@ -0,0 +1,135 @@
+#include "extrusion.h"
+#include "stats1d.h"
+#include "workpool.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+
+#ifndef HPARAMETERS
+#define HPARAMETERS
+#include "parameters.h"
+#endif
+
+/////////////////////////////////////////////
+// Write the extruders at time t in the layout of the loopExtrusion log
+/////////////////////////////////////////////
+void WriteFrame(ofstream &fout, Extrusion &e, double t)
+{
+    fout << "Time = " << t << "\t\t" << "# extruders = " << e.n_extr_bound << "\n";
+    for (int w=0; w<e.n_extr_bound; w++)
+       fout << e.Index(w) << " " << e.Left(w) << " " << e.Right(w) << "\n";
+}
+
+/////////////////////////////////////////////
+// Run the kinetics up to time_max, sampling the extruders every sample_time;
+// return the number of events
+/////////////////////////////////////////////
+long RunKinetics(Parameters &parm, Extrusion &e, Stats1D &stats, ofstream *traj)
+{
+    double time=0, time_next;
+    bool ok=true;
+    long iSample=0, nEvents=0;
+
+    while ( iSample*parm.sample_time <= parm.time_max )
+    {
+       // time of next event; if there is none the state does not change anymore
+       if (ok) ok = e.DrawTime( parm.debug );
+       time_next = ok ? time + e.tau : HUGE_VAL;
+
+       // sample the state, which holds until the next event
+       while ( iSample*parm.sample_time < time_next && iSample*parm.sample_time <= parm.time_max )
+       {
+          stats.Sample(e);
+          if (traj) WriteFrame(*traj, e, iSample*parm.sample_time);
+          iSample ++;
+       }
+       if (!ok || time_next > parm.time_max) break;
+
+       // Gillespie event
+       e.CatchError( e.ApplyEvent( parm.debug ) );
+       time = time_next;
+       nEvents ++;
+    }
+
+    if (!ok && traj) cout << "Stopped at time " << time << ": " << e.exitError << endl;
+
+    return nEvents;
+}
+
+/////////////////////////////////////////////
+// Loop extrusion kinetics alone, without LAMMPS:
+// the extruders are sampled every sample_time up to time_max,
+// in a single run or in an ensemble of n_replicas runs
+/////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    //Defining variables
+    long nEvents=0;
+
+    //Reading Gillespie parameters
+    Parameters parm(argc, argv);
+
+    //Initializing extrusion algorithm
+    Extrusion e( parm );
+
+    //Reading CTCF sites
+    e.CatchError( e.ReadCTCF(parm.ctcf_file) );
+
+    Stats1D stats(parm.length, parm.contact_bin);
+    auto start = chrono::steady_clock::now();
+
+    if (parm.n_replicas == 1)
+    {
+       //Reading state
+       e.CatchError( e.ReadState(parm.state_file, parm.debug) );
+
+       //Opening trajectory
+       ofstream traj(parm.output_prefix+"_traj.dat");
+       if (!traj.is_open()) parm.Error("Cannot open file "+parm.output_prefix+"_traj.dat");
+       traj << fixed;
+
+       nEvents = RunKinetics(parm, e, stats, &traj);
+       cout << "Final number of extruders: " << e.n_extr_bound << endl;
+
+       traj.close();
+    }
+    else
+    {
+       //Ensemble of independent replicas, all sharing the CTCF sites of e
+       WorkPool pool(parm.n_threads);
+       vector<Stats1D> threadStats(pool.n_threads, stats);
+       vector<long> threadEvents(pool.n_threads, 0);
+
+       cout << "Running " << parm.n_replicas << " replicas on " << pool.n_threads << " threads" << endl;
+
+       pool.Run(parm.n_replicas, [&](int replica, int thread)
+       {
+          Parameters parmReplica = parm;
+          parmReplica.seed = e.seed;
+          parmReplica.replica = replica;
+
+          Extrusion eReplica( parmReplica );
+          eReplica.CatchError( eReplica.ShareCTCF(e) );
+          eReplica.CatchError( eReplica.ReadState(parm.state_file, parm.debug) );
+
+          threadEvents[thread] += RunKinetics(parmReplica, eReplica, threadStats[thread], NULL);
+       });
+
+       for (int t=0; t<pool.n_threads; t++)
+       {
+          stats.Merge(threadStats[t]);
+          nEvents += threadEvents[t];
+       }
+    }
+
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Events: " << nEvents << " in " << elapsed << " s (" << nEvents/max(elapsed,1E-9) << " events/s)" << endl;
+
+    //Writing statistics
+    if (!stats.Write(parm.output_prefix)) parm.Error("Cannot write statistics with prefix "+parm.output_prefix);
+
+    cout << "Done!" << endl;
+
+    return 0;
+}
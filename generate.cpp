@@ -0,0 +1,260 @@
+#include "rng.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Options of the generator, with their defaults
+/////////////////////////////////////////////
+struct Options
+{
+    string prefix = "system";
+    long n_chains = 1;
+    long n_beads = 1000;          // beads per chain
+    double bond_length = 1.0;
+    double density = 0.1;         // beads per unit volume of the region of the chain origins
+    int bond_types = 2;
+    double ctcf_density = 0.01;   // CTCF sites per bead
+    double p_left = 0.4;          // fraction of CTCF sites of type -1, +1 and 2
+    double p_right = 0.4;
+    double p_both = 0.2;
+    bool junctions = true;        // bidirectional barriers at the ends of each chain
+    double extr_density = 0.;     // extruders per bead in the initial state
+    int n_extr_max = 0;
+    uint64_t seed = 1;
+};
+
+/////////////////////////////////////////////
+// Stop with an error message
+/////////////////////////////////////////////
+void Error(string message)
+{
+    cerr << "ERROR: " << message << endl;
+    exit(1);
+}
+
+/////////////////////////////////////////////
+// Read the options given as key value pairs on the command line
+/////////////////////////////////////////////
+Options ReadOptions(int argc, char **argv)
+{
+    Options opt;
+
+    if (argc % 2 == 0) Error("Options must be given as key value pairs");
+    for (int k=1; k<argc; k+=2)
+    {
+       string key = argv[k], value = argv[k+1];
+       if ( key == "prefix" ) opt.prefix = value;
+       else if ( key == "n_chains" ) opt.n_chains = stol( value );
+       else if ( key == "n_beads" ) opt.n_beads = stol( value );
+       else if ( key == "bond_length" ) opt.bond_length = stod( value );
+       else if ( key == "density" ) opt.density = stod( value );
+       else if ( key == "bond_types" ) opt.bond_types = stoi( value );
+       else if ( key == "ctcf_density" ) opt.ctcf_density = stod( value );
+       else if ( key == "p_left" ) opt.p_left = stod( value );
+       else if ( key == "p_right" ) opt.p_right = stod( value );
+       else if ( key == "p_both" ) opt.p_both = stod( value );
+       else if ( key == "junctions" ) opt.junctions = (value == "yes");
+       else if ( key == "extr_density" ) opt.extr_density = stod( value );
+       else if ( key == "n_extr_max" ) opt.n_extr_max = stoi( value );
+       else if ( key == "seed" ) opt.seed = stoull( value );
+       else Error("Unknown option "+key);
+    }
+
+    if (opt.n_chains < 1 || opt.n_beads < 2) Error("n_chains must be at least 1 and n_beads at least 2");
+    if (opt.n_chains * opt.n_beads > 2147483647L) Error("Too many beads for the 32-bit site indices");
+    if (opt.density <= 0. || opt.bond_length <= 0.) Error("density and bond_length must be positive");
+    if (opt.bond_types < 2) Error("bond_types must be at least 2 (backbone and extruders)");
+    if (opt.p_left < 0. || opt.p_right < 0. || opt.p_both < 0. || opt.p_left + opt.p_right + opt.p_both <= 0.) Error("p_left, p_right and p_both must be non-negative, not all zero");
+    if (opt.ctcf_density < 0. || opt.ctcf_density > 1. || opt.extr_density < 0. || opt.extr_density > 0.5) Error("ctcf_density must be in [0,1] and extr_density in [0,0.5]");
+
+    return opt;
+}
+
+/////////////////////////////////////////////
+// Random walk of the chains, bead after bead; the same seed gives the
+// same walk, so the box is found in a first pass and the atoms are
+// written in a second one without keeping them in memory
+/////////////////////////////////////////////
+class Walk
+{
+
+public:
+    Walk(const Options &opt) : opt(opt)
+    {
+       rng.Seed(opt.seed, 0, 0);
+       side = cbrt(opt.n_chains * opt.n_beads / opt.density);
+       bead = opt.n_beads - 1;
+       chain = -1;
+    }
+
+    // position of the next bead, false at the end
+    bool Next(long &c, double *x)
+    {
+       if (++bead == opt.n_beads)
+       {
+          if (++chain == opt.n_chains) return false;
+          bead = 0;
+          for (int d=0; d<3; d++) r[d] = side * rng.Double();
+       }
+       else
+       {
+          double z = 2. * rng.Double() - 1.;
+          double phi = 2. * M_PI * rng.Double();
+          double s = sqrt(1. - z * z);
+          r[0] += opt.bond_length * s * cos(phi);
+          r[1] += opt.bond_length * s * sin(phi);
+          r[2] += opt.bond_length * z;
+       }
+       c = chain;
+       for (int d=0; d<3; d++) x[d] = r[d];
+       return true;
+    }
+
+private:
+    const Options &opt;
+    Rng rng;
+    double side;
+    long chain, bead;
+    double r[3];
+};
+
+/////////////////////////////////////////////
+// LAMMPS data file (atom_style molecular), one molecule per chain
+/////////////////////////////////////////////
+void WriteData(const Options &opt)
+{
+    long n_atoms = opt.n_chains * opt.n_beads;
+    double lo[3] = {HUGE_VAL, HUGE_VAL, HUGE_VAL}, hi[3] = {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+    double x[3];
+    long c;
+
+    // first pass: box
+    Walk box(opt);
+    while (box.Next(c, x))
+       for (int d=0; d<3; d++)
+       {
+          lo[d] = min(lo[d], x[d]);
+          hi[d] = max(hi[d], x[d]);
+       }
+
+    ofstream fout(opt.prefix+".data");
+    if (!fout.is_open()) Error("Cannot open file "+opt.prefix+".data");
+    fout << setprecision(10);
+
+    fout << "LAMMPS Description -> " << opt.n_chains << " polymers with " << opt.n_beads << " beads\n\n";
+    fout << n_atoms << " atoms\n" << n_atoms - opt.n_chains << " bonds\n\n";
+    fout << "1 atom types\n" << opt.bond_types << " bond types\n\n";
+    const char *axis[3] = {"x", "y", "z"};
+    for (int d=0; d<3; d++)
+       fout << lo[d] - opt.bond_length << " " << hi[d] + opt.bond_length << " " << axis[d] << "lo " << axis[d] << "hi\n";
+    fout << "\nMasses\n\n1 1\n\nAtoms\n\n";
+
+    // second pass: atoms
+    Walk atoms(opt);
+    for (long id=1; atoms.Next(c, x); id++)
+       fout << id << " " << c + 1 << " 1 " << x[0] << " " << x[1] << " " << x[2] << " 0 0 0\n";
+
+    fout << "\nBonds\n\n";
+    long b = 1;
+    for (long ch=0; ch<opt.n_chains; ch++)
+       for (long k=0; k<opt.n_beads-1; k++, b++)
+          fout << b << " 1 " << ch * opt.n_beads + k + 1 << " " << ch * opt.n_beads + k + 2 << "\n";
+
+    fout.close();
+}
+
+/////////////////////////////////////////////
+// CTCF file in the format of Extrusion::ReadCTCF (site type),
+// sites counted from 0 over all the chains
+/////////////////////////////////////////////
+void WriteCTCF(const Options &opt)
+{
+    Rng rng;
+    rng.Seed(opt.seed, 1, 0);
+    double p_all = opt.p_left + opt.p_right + opt.p_both;
+    long n_sites = opt.n_chains * opt.n_beads;
+
+    ofstream fout(opt.prefix+"_ctcf.data");
+    if (!fout.is_open()) Error("Cannot open file "+opt.prefix+"_ctcf.data");
+
+    for (long s=0; s<n_sites; s++)
+    {
+       long bead = s % opt.n_beads;
+       if (opt.junctions && opt.n_chains > 1 && (bead == 0 || bead == opt.n_beads - 1))
+       {
+          // barriers at the ends of the chains, which the extruders would otherwise reach and unbind
+          fout << s << " 2\n";
+          continue;
+       }
+       if (rng.Double() >= opt.ctcf_density) continue;
+
+       double u = rng.Double() * p_all;
+       int type = (u < opt.p_left) ? -1 : (u < opt.p_left + opt.p_right ? 1 : 2);
+       fout << s << " " << type << "\n";
+    }
+
+    fout.close();
+}
+
+/////////////////////////////////////////////
+// Initial state in the format of Extrusion::ReadState: extruders on
+// neighbouring beads of the same chain, not overlapping
+/////////////////////////////////////////////
+void WriteState(const Options &opt)
+{
+    Rng rng;
+    rng.Seed(opt.seed, 2, 0);
+    long n_sites = opt.n_chains * opt.n_beads;
+
+    // the number of extruders comes first: count them with the same stream, then write them
+    long n_extr = 0;
+    for (int pass=0; pass<2; pass++)
+    {
+       ofstream fout;
+       if (pass == 1)
+       {
+          fout.open(opt.prefix+"_state.data");
+          if (!fout.is_open()) Error("Cannot open file "+opt.prefix+"_state.data");
+          fout << n_sites << "\n" << n_extr << "\n" << max((long)opt.n_extr_max, n_extr + 1) << "\n";
+          rng.Seed(opt.seed, 2, 0);
+       }
+
+       long index = 0;
+       for (long s=0; s<n_sites-1; s++)
+       {
+          if (s % opt.n_beads == opt.n_beads - 1 || rng.Double() >= opt.extr_density) continue;
+          if (pass == 1) fout << s << " " << s + 1 << " 0 0 " << index << "\n";
+          index++;
+          s++;
+       }
+       n_extr = index;
+    }
+}
+
+/////////////////////////////////////////////
+// Inputs of loopExtrusion and extrusion1D for large systems: LAMMPS data
+// file, CTCF sites and initial state, written as they are generated.
+// Usage: generate [key value] ...
+/////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    Options opt = ReadOptions(argc, argv);
+
+    cout << "Writing " << opt.n_chains << " chains of " << opt.n_beads << " beads with prefix " << opt.prefix << endl;
+
+    WriteData(opt);
+    WriteCTCF(opt);
+    WriteState(opt);
+
+    cout << "Use length " << opt.n_chains * opt.n_beads << " and n_chains " << opt.n_chains << " in the parameter file" << endl;
+    cout << "Done!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "extrusion.h"
+#include <iostream>
+#include <string>
+
+#ifndef HPARAMETERS
+#define HPARAMETERS
+#include "parameters.h"
+#endif
+
+/////////////////////////////////////////////
+// CTCF and state files of a parameter file converted to the binary
+// formats, which ReadCTCF and ReadState load without parsing (e.g.
+// for many launches of ensembles on the same genome)
+/////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    //Reading parameters, with the text files to convert
+    Parameters parm(argc, argv);
+    if (argc != 2) parm.Error("Usage: inputconv parameters_file");
+
+    Extrusion e( parm );
+
+    if (!parm.ctcf_file.empty())
+    {
+       e.CatchError( e.ReadCTCF(parm.ctcf_file) );
+       e.CatchError( e.WriteCTCF(parm.ctcf_file+".bin") );
+    }
+    if (!parm.state_file.empty())
+    {
+       e.CatchError( e.ReadState(parm.state_file, false) );
+       e.CatchError( e.WriteState(parm.state_file+".bin") );
+    }
+
+    //Lines of the parameter file using them
+    cout << "Binary files written, to be used with:" << endl;
+    if (!parm.ctcf_file.empty()) cout << "ctcf_file " << parm.ctcf_file << ".bin" << endl;
+    if (!parm.state_file.empty()) cout << "state_file " << parm.state_file << ".bin" << endl;
+
+    return 0;
+}
@@ -1,221 +1,504 @@
-#include "interface_lmp.h"
-#include "update.h"
-
-Interface_lmp::Interface_lmp(int argc, char **argv, bool screen)
-{
-   cout << "Opening interface with LAMMPS..." << endl;
-   cout << "" << endl;
-   initiate_lmp(argc, argv, screen);
-}
-
-void Interface_lmp::initiate_lmp(int argc, char **argv, bool screen)
-{
-   cout << "Initializing LAMMPS..." << endl;
-   cout << "" << endl;
-
-   MPI_Init(&argc,&argv);
-  
-  /*
-  if (argc != 3) {
-    printf("Syntax: simpleCC P in.lammps\n");
-    exit(1);
-  }*/
-
-  int me,nprocs;
-  MPI_Comm_rank(MPI_COMM_WORLD,&me);
-  MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
-
-  //int lammps;
-  lammps = MPI_UNDEFINED;
-
-  // open LAMMPS input script
-  
-  FILE *fp;
-  if (me == 0) {
-     fp = fopen(argv[2],"r");
-     if (fp == NULL) {
-        printf("ERROR: Could not open LAMMPS input script\n");
-     }
-  }
-  
-  // run the input script thru LAMMPS one line at a time until end-of-file
-  // driver proc 0 reads a line, Bcasts it to all procs
-  // (could just send it to proc 0 of comm_lammps and let it Bcast)
-  // all LAMMPS procs call input->one() on the line
-  
-  //LAMMPS_NS::LAMMPS *lmp = NULL;
-  lmp = new LAMMPS_NS::LAMMPS(0,NULL,MPI_COMM_WORLD);
-  
-  //Turn off screen output
-  if (screen == false){
-     lmp->screen = NULL;
-  }  
-  //Turn off log output
-  lmp->logfile = NULL;  
-
-  isFirstRun = true;
-
-  //lammps_command(lmp, "screen none");
-  int n;
-  char line[1024];
-  while (1) {
-      if (fgets(line,1024,fp) == NULL) n = 0;
-      else n = strlen(line) + 1;
-      if (n == 0) fclose(fp);
-      if (n == 0) break;
-      lammps_command(lmp,line);
-  }
- 
-}
-
-void Interface_lmp::set_timestep(double timestep)
-{
-   ostringstream line;
-   line << "timestep " << timestep;
-   string MyString  = line.str();
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear();
-
-}
-
-void Interface_lmp::load_bond(int bond_type, int new_id1, int new_id2)
-{
-   //create bond
-   ostringstream line;
-   line << "create_bonds single/bond " << bond_type << " " << new_id1 << " " << new_id2;
-   string MyString  = line.str();
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear();
-}
-
-void Interface_lmp::unload_bond(int bond_type, int old_id1, int old_id2)
-{
-   stringstream line;
-   line << "group to_remove id " << old_id1 << " " << old_id2;
-   string MyString = line.str();
-
-   //create group with atoms whose bond must be removed 
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear();
-   
-   //delete bond
-   line << "delete_bonds to_remove bond " << bond_type << " remove";
-   MyString = line.str();
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear();
-   
-   //delete group 
-   lammps_command(lmp,"group to_remove delete");
-}
-
-void Interface_lmp::update_bonds(int bond_type, bool add_link, bool delete_link, int add_link_i, int add_link_j, int delete_link_i, int delete_link_j)
-{
-   if (add_link) load_bond(bond_type, add_link_i+1, add_link_j+1);
-   if (delete_link) unload_bond(bond_type, delete_link_i+1, delete_link_j+1);
-} 
-
-void Interface_lmp::run_dynamics(int steps)
-{  
-   lmp->update->restrict_output = 0;
-
-   if (isFirstRun = true) {
-      stringstream line;
-      line << "run " << steps;
-      string MyString = line.str();
-
-      //launch lammps dynamics
-      lammps_command(lmp, MyString.c_str());
-      line.str("");
-      line.clear();
-   
-      isFirstRun = false;
-   }
-   else {
-      stringstream line;
-      line << "run " << steps << " pre no post no";
-      string MyString = line.str();
-
-      //launch lammps dynamics
-      lammps_command(lmp, MyString.c_str());
-      line.str("");
-      line.clear(); 
-   }
-
-}
-
-void Interface_lmp::write_data(string str)
-{
-   stringstream line;
-   line << str;
-   string MyString = line.str();
-
-   //write data file
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear();  
-}
-
-void Interface_lmp::print_bonds(int (*extrList)[5], int n_extr_bound)
-{
-   //initialise variables
-   //int tagintsize;
-   //int64_t i, natoms;
-   int i, natoms;
-   int id1, id2;
- 
-   double *x = NULL;
-   //gather atoms information
-   natoms = *(int *)lammps_extract_global(lmp, "natoms");
-   x = new double[3*natoms];
-   lammps_gather_atoms(lmp,(char *) "x",1,3,x);
-         
-   float x_cm, y_cm, z_cm; //center of mass of two beads = position of extruder
-   for (int i = 0; i < n_extr_bound; i++ )
-   {   
-      id1 = extrList[i][0]+1; id2 = extrList[i][1]+1;
-      x_cm = (x[3*id1]+x[3*id2])/2;
-      y_cm = (x[3*id1+1]+x[3*id2+1])/2;
-      z_cm = (x[3*id1+2]+x[3*id2+2])/2;
-      cout << extrList[i][4] << " " << id1 << " " << id2 << " " << x_cm << " " << y_cm << " " << z_cm << endl;  
-   }   
-}
-      
-void Interface_lmp::minimize()
-{  
-   //don't dump/output minimization data
-   lmp->update->restrict_output = 1;
-
-   //getting dynamics time
-   int * ntimestep_ptr;
-   int ntimestep;
-   ntimestep_ptr = (int *) lammps_extract_global(lmp, "ntimestep"); 
-   ntimestep = *ntimestep_ptr; 
-  
-   //minimize
-   stringstream line; 
-   line << "minimize 1e-5 1e-5 1000 1000";
-   string MyString = line.str();
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear();
- 
-   //don't count minimization steps as dynamics steps
-   line << "reset_timestep " << ntimestep;
-   MyString = line.str();
-   lammps_command(lmp, MyString.c_str());
-   line.str("");
-   line.clear(); 
-} 
-
-void Interface_lmp::close_lmp()
-{
-  //closing lammps and MPI
-  delete lmp;
-
-  MPI_Finalize();
-  
-}
+#include "interface_lmp.h"
+#include "update.h"
+#include "atom.h"
+#include "force.h"
+#include "modify.h"
+#include "fix.h"
+
+Interface_lmp::Interface_lmp(int argc, char **argv, bool screen, string restart_file)
+{
+   cout << "Opening interface with LAMMPS..." << endl;
+   cout << "" << endl;
+   initiate_lmp(argc, argv, screen, restart_file);
+}
+
+void Interface_lmp::initiate_lmp(int argc, char **argv, bool screen, string restart_file)
+{
+   cout << "Initializing LAMMPS..." << endl;
+   cout << "" << endl;
+
+   MPI_Init(&argc,&argv);
+  
+  /*
+  if (argc != 3) {
+    printf("Syntax: simpleCC P in.lammps\n");
+    exit(1);
+  }*/
+
+  int me,nprocs;
+  MPI_Comm_rank(MPI_COMM_WORLD,&me);
+  MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+  myProc = me;
+
+  //int lammps;
+  lammps = MPI_UNDEFINED;
+
+  // open LAMMPS input script
+  
+  FILE *fp;
+  if (me == 0) {
+     fp = fopen(argv[2],"r");
+     if (fp == NULL) {
+        printf("ERROR: Could not open LAMMPS input script\n");
+     }
+  }
+  
+  // run the input script thru LAMMPS one line at a time until end-of-file
+  // driver proc 0 reads a line, Bcasts it to all procs
+  // (could just send it to proc 0 of comm_lammps and let it Bcast)
+  // all LAMMPS procs call input->one() on the line
+  
+  //LAMMPS_NS::LAMMPS *lmp = NULL;
+  lmp = new LAMMPS_NS::LAMMPS(0,NULL,MPI_COMM_WORLD);
+  
+  //Turn off screen output
+  if (screen == false){
+     lmp->screen = NULL;
+  }  
+  //Turn off log output
+  lmp->logfile = NULL;  
+
+  isFirstRun = true;
+  direct_bonds = NULL;
+  hook = NULL;
+  ramp_type = 0;
+  n_commands = 0;
+
+  //lammps_command(lmp, "screen none");
+  int n;
+  char line[1024];
+  while (1) {
+      if (fgets(line,1024,fp) == NULL) n = 0;
+      else n = strlen(line) + 1;
+      if (n == 0) fclose(fp);
+      if (n == 0) break;
+
+      //resuming a run: the system, already relaxed, at its timestep and with its velocities, comes
+      //from the restart file, and the dump files of the stopped run are continued, not truncated
+      string first, dump_id;
+      if (!restart_file.empty())
+      {
+         istringstream(line) >> first >> dump_id;
+         if (first == "minimize" || first == "reset_timestep" || first == "velocity") continue;
+         if (first == "read_data") snprintf(line, 1024, "read_restart %s\n", restart_file.c_str());
+      }
+      command(line);
+      if (first == "dump") command(("dump_modify " + dump_id + " append yes").c_str());
+  }
+ 
+}
+
+void Interface_lmp::set_timestep(double timestep)
+{
+   ostringstream line;
+   line << "timestep " << timestep;
+   string MyString  = line.str();
+   command(MyString.c_str());
+   line.str("");
+   line.clear();
+
+}
+
+void Interface_lmp::load_bond(int bond_type, int new_id1, int new_id2)
+{
+   //create bond
+   ostringstream line;
+   line << "create_bonds single/bond " << bond_type << " " << new_id1 << " " << new_id2;
+   string MyString  = line.str();
+   command(MyString.c_str());
+   line.str("");
+   line.clear();
+
+   bonds.insert(bond_key(bond_type, new_id1, new_id2));
+}
+
+void Interface_lmp::record_bond(int bond_type, int id1, int id2)
+{
+   //bond already in LAMMPS (e.g. read from a restart file), only remembered
+   bonds.insert(bond_key(bond_type, id1, id2));
+}
+
+void Interface_lmp::unload_bond(int bond_type, int old_id1, int old_id2)
+{
+   stringstream line;
+   line << "group to_remove id " << old_id1 << " " << old_id2;
+   string MyString = line.str();
+
+   //create group with atoms whose bond must be removed 
+   command(MyString.c_str());
+   line.str("");
+   line.clear();
+   
+   //delete bond
+   line << "delete_bonds to_remove bond " << bond_type << " remove";
+   MyString = line.str();
+   command(MyString.c_str());
+   line.str("");
+   line.clear();
+   
+   //delete group 
+   command("group to_remove delete");
+
+   bonds.erase(bond_key(bond_type, old_id1, old_id2));
+}
+
+void Interface_lmp::update_bonds(int bond_type, bool add_link, bool delete_link, int add_link_i, int add_link_j, int delete_link_i, int delete_link_j)
+{
+   //only record the change, LAMMPS is updated by apply_bonds
+   if (add_link) pending[bond_key(bond_type, add_link_i+1, add_link_j+1)]++;
+   if (delete_link) pending[bond_key(bond_type, delete_link_i+1, delete_link_j+1)]--;
+} 
+
+int Interface_lmp::n_pending()
+{
+   //net bond changes not applied yet
+   int n = 0;
+   for (map<tuple<int,int,int>, int>::iterator it = pending.begin(); it != pending.end(); ++it)
+      n += abs(it->second);
+   return n;
+}
+
+void Interface_lmp::set_direct_bonds(bool direct)
+{
+   //bonds read from the data file or created by load_bond can be removed in both modes
+   delete direct_bonds;
+   direct_bonds = direct ? new Bonds_lmp(lmp) : NULL;
+}
+
+void Interface_lmp::apply_bonds(bool in_run)
+{
+   vector<tuple<int,int,int> > to_add, to_remove;
+
+   //net changes since the last call (a leg stepping i->i+1->i+2 leaves one removal and one addition)
+   for (map<tuple<int,int,int>, int>::iterator it = pending.begin(); it != pending.end(); ++it)
+   {
+      if (it->second > 0) to_add.push_back(it->first);
+      else if (it->second < 0) to_remove.push_back(it->first);
+   }
+   pending.clear();
+
+   for (size_t k = 0; k < to_remove.size(); k++) bonds.erase(to_remove[k]);
+
+   //bonds changed in place on the owning ranks, no command is parsed
+   if (direct_bonds != NULL)
+   {
+      for (size_t k = 0; k < to_remove.size(); k++)
+         direct_bonds->remove(get<0>(to_remove[k]), get<1>(to_remove[k]), get<2>(to_remove[k]));
+      for (size_t k = 0; k < to_add.size(); k++)
+      {
+         //new bonds start soft, they get their own type at the end of the ramp
+         if (ramp_type > 0)
+         {
+            direct_bonds->add(ramp_type, get<1>(to_add[k]), get<2>(to_add[k]));
+            ramping.push_back(to_add[k]);
+         }
+         else direct_bonds->add(get<0>(to_add[k]), get<1>(to_add[k]), get<2>(to_add[k]));
+         bonds.insert(to_add[k]);
+      }
+
+      //the topology is rebuilt by the setup of the next minimize or run, or inside a run
+      //by a reneighboring at the next timestep, which also applies the new special flags
+      if (!direct_bonds->commit(in_run))
+      {
+         if (myProc == 0) printf("ERROR: %s\n", direct_bonds->error.c_str());
+         MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+      if (in_run && direct_bonds->changed) hook->next_reneighbor = lmp->update->ntimestep + 1;
+      return;
+   }
+
+   //split removals in groups of atoms with no surviving bond of the same type between them,
+   //so delete_bonds removes exactly the requested bonds; usually a single group is enough
+   map<int, vector<int> > kept; //surviving partners of each atom
+   for (set<tuple<int,int,int> >::iterator it = bonds.begin(); it != bonds.end(); ++it)
+   {
+      kept[get<1>(*it)].push_back(get<2>(*it));
+      kept[get<2>(*it)].push_back(get<1>(*it));
+   }
+
+   vector<set<int> > groups;
+   vector<int> group_type;
+   for (size_t k = 0; k < to_remove.size(); k++)
+   {
+      int type = get<0>(to_remove[k]);
+      int ids[2] = {get<1>(to_remove[k]), get<2>(to_remove[k])};
+      size_t g;
+      for (g = 0; g < groups.size(); g++)
+      {
+         bool clash = (group_type[g] != type);
+         for (int a = 0; a < 2 && !clash; a++)
+            for (size_t n = 0; n < kept[ids[a]].size() && !clash; n++)
+            {
+               int partner = kept[ids[a]][n];
+               clash = groups[g].count(partner) || partner == ids[1-a];
+            }
+         if (!clash) break;
+      }
+      if (g == groups.size())
+      {
+         groups.push_back(set<int>());
+         group_type.push_back(type);
+      }
+      groups[g].insert(ids[0]);
+      groups[g].insert(ids[1]);
+   }
+
+   //all changes are sent to LAMMPS in one batch
+   ostringstream line;
+   for (size_t g = 0; g < groups.size(); g++)
+   {
+      line << "group to_remove id";
+      for (set<int>::iterator it = groups[g].begin(); it != groups[g].end(); ++it) line << " " << *it;
+      line << "\n";
+      line << "delete_bonds to_remove bond " << group_type[g] << " remove\n";
+      line << "group to_remove delete\n";
+   }
+   //special lists are rebuilt only once, with the last bond
+   for (size_t k = 0; k < to_add.size(); k++)
+   {
+      line << "create_bonds single/bond " << get<0>(to_add[k]) << " " << get<1>(to_add[k]) << " " << get<2>(to_add[k]);
+      line << " special " << (k+1 == to_add.size() ? "yes" : "no") << "\n";
+      bonds.insert(to_add[k]);
+   }
+
+   string MyString = line.str();
+   if (!MyString.empty()) lammps_commands_string(lmp, MyString.c_str());
+   n_commands += count(MyString.begin(), MyString.end(), '\n');
+}
+
+void Interface_lmp::set_ramp(int bond_type)
+{
+   //needs the direct bond layer to change the type of single bonds
+   if (bond_type > lmp->atom->nbondtypes)
+   {
+      if (myProc == 0) printf("ERROR: bond type %d for the ramp is not defined in LAMMPS\n", bond_type);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+   }
+   ramp_type = bond_type;
+}
+
+double Interface_lmp::new_bond_length()
+{
+   //longest bond added by the last apply_bonds
+   return direct_bonds != NULL ? direct_bonds->new_length : 0.;
+}
+
+void Interface_lmp::run_ramped(int steps, int ramp_steps, int stages)
+{
+   if (ramping.empty())
+   {
+      if (steps > 0) run_dynamics(steps);
+      return;
+   }
+   if (steps < 1)
+   {
+      //no run to ramp in (timestep longer than the window), the new bonds get their full stiffness at once
+      end_ramp();
+      return;
+   }
+
+   //stiffness and rest length of the extruder bonds (bond_style harmonic)
+   int dim;
+   int type = get<0>(ramping[0]);
+   double *k = (double *) lmp->force->bond->extract("k", dim);
+   double *r0 = (double *) lmp->force->bond->extract("r0", dim);
+   if (k == NULL || r0 == NULL)
+   {
+      if (myProc == 0) printf("ERROR: the bond style has no k and r0 to ramp\n");
+      MPI_Abort(MPI_COMM_WORLD, 1);
+   }
+   ramp.k = k;
+   ramp.k_final = k[type];
+   ramp.steps = min(ramp_steps, steps);
+   ramp.stages = max(1, min(stages, ramp.steps));
+   ramp.step0 = lmp->update->ntimestep;
+
+   //first stage, then the callback raises the stiffness at the end of each stage, inside the same run
+   ostringstream line;
+   line << "bond_coeff " << ramp_type << " " << ramp.k_final / ramp.stages << " " << r0[type];
+   command(line.str().c_str());
+   command("fix ramp all external pf/callback 1 1");
+   lammps_set_fix_external_callback(lmp, "ramp", ramp_stage, this);
+
+   run_dynamics(steps);
+   command("unfix ramp");
+   end_ramp();
+}
+
+void Interface_lmp::end_ramp()
+{
+   //the ramped bonds become normal extruder bonds, so a later removal finds them with their own type
+   for (size_t b = 0; b < ramping.size(); b++)
+      direct_bonds->retype(ramp_type, get<0>(ramping[b]), get<1>(ramping[b]), get<2>(ramping[b]));
+   ramping.clear();
+}
+
+void Interface_lmp::ramp_stage(void *ptr, LAMMPS_NS::bigint ntimestep, int nlocal, int *, double **, double **fexternal)
+{
+   Interface_lmp *inter = (Interface_lmp *) ptr;
+   Ramp &ramp = inter->ramp;
+
+   //no external force, the fix is only used as a hook
+   for (int i = 0; i < nlocal; i++) fexternal[i][0] = fexternal[i][1] = fexternal[i][2] = 0.;
+
+   //stiffness of the stage of the next timestep, read directly by the bond style
+   long done = ntimestep - ramp.step0;
+   int stage = min((long) ramp.stages, done * ramp.stages / ramp.steps + 1);
+   ramp.k[inter->ramp_type] = ramp.k_final * stage / ramp.stages;
+}
+
+void Interface_lmp::command(const char *line)
+{
+   //all single commands go through here to be counted
+   n_commands++;
+   lammps_command(lmp, line);
+}
+
+tuple<int,int,int> Interface_lmp::bond_key(int bond_type, int id1, int id2)
+{
+   if (id2 < id1) swap(id1, id2);
+   return make_tuple(bond_type, id1, id2);
+}
+
+void Interface_lmp::run_dynamics(int steps)
+{  
+   lmp->update->restrict_output = 0;
+
+   if (isFirstRun = true) {
+      stringstream line;
+      line << "run " << steps;
+      string MyString = line.str();
+
+      //launch lammps dynamics
+      command(MyString.c_str());
+      line.str("");
+      line.clear();
+   
+      isFirstRun = false;
+   }
+   else {
+      stringstream line;
+      line << "run " << steps << " pre no post no";
+      string MyString = line.str();
+
+      //launch lammps dynamics
+      command(MyString.c_str());
+      line.str("");
+      line.clear(); 
+   }
+
+}
+
+void Interface_lmp::run_continuous(LAMMPS_NS::bigint steps, FixExternalFnPtr callback, void *caller)
+{
+   lmp->update->restrict_output = 0;
+
+   //callback at the end of the force calculation of every timestep
+   command("fix extrusion all external pf/callback 1 1");
+   lammps_set_fix_external_callback(lmp, "extrusion", callback, caller);
+
+   //the fix can then ask for a reneighboring after the bonds change (as fix bond/create),
+   //it must be known to the neighbor lists before the setup of the run
+   hook = lmp->modify->fix[lmp->modify->find_fix("extrusion")];
+   hook->force_reneighbor = 1;
+   hook->next_reneighbor = -1;
+
+   //launch lammps dynamics, setup is done once for the whole simulation
+   stringstream line;
+   line << "run " << steps;
+   string MyString = line.str();
+   command(MyString.c_str());
+
+   command("unfix extrusion");
+   hook = NULL;
+}
+
+void Interface_lmp::write_data(string str)
+{
+   stringstream line;
+   line << str;
+   string MyString = line.str();
+
+   //write data file
+   command(MyString.c_str());
+   line.str("");
+   line.clear();  
+}
+
+void Interface_lmp::write_restart(string fileName)
+{
+   //binary restart of LAMMPS, read back in place of read_data when resuming
+   stringstream line;
+   line << "write_restart " << fileName;
+   string MyString = line.str();
+   command(MyString.c_str());
+}
+
+void Interface_lmp::extruder_positions(const vector<int> &extruders, vector<float> &positions)
+{
+   LAMMPS_NS::Atom *atom = lmp->atom;
+   int n_extr = extruders.size()/3;
+
+   //coordinates of the two beads of each extruder, from the ranks owning them (zero elsewhere)
+   vector<double> local(6*n_extr, 0.), x(6*n_extr);
+   for (int k = 0; k < n_extr; k++)
+      for (int b = 0; b < 2; b++)
+      {
+         int m = atom->map(extruders[3*k+1+b]+1);
+         if (m < 0 || m >= atom->nlocal) continue;
+         for (int d = 0; d < 3; d++) local[6*k+3*b+d] = atom->x[m][d];
+      }
+   MPI_Reduce(local.data(), x.data(), 6*n_extr, MPI_DOUBLE, MPI_SUM, 0, lmp->world);
+
+   //center of mass of two beads = position of extruder, on rank 0
+   positions.resize(3*n_extr);
+   for (int k = 0; k < n_extr; k++)
+      for (int d = 0; d < 3; d++) positions[3*k+d] = (x[6*k+d]+x[6*k+3+d])/2;
+}
+
+void Interface_lmp::print_bonds(const vector<int> &extruders, const vector<float> &positions)
+{
+   if (myProc != 0) return;
+
+   //no flush on each line
+   for (size_t k = 0; k < extruders.size()/3; k++ )
+      cout << extruders[3*k] << " " << extruders[3*k+1]+1 << " " << extruders[3*k+2]+1 << " " << positions[3*k] << " " << positions[3*k+1] << " " << positions[3*k+2] << "\n";
+   cout.flush();
+}
+      
+void Interface_lmp::minimize()
+{  
+   //don't dump/output minimization data
+   lmp->update->restrict_output = 1;
+
+   //getting dynamics time
+   int * ntimestep_ptr;
+   int ntimestep;
+   ntimestep_ptr = (int *) lammps_extract_global(lmp, "ntimestep"); 
+   ntimestep = *ntimestep_ptr; 
+  
+   //minimize
+   stringstream line; 
+   line << "minimize 1e-5 1e-5 1000 1000";
+   string MyString = line.str();
+   command(MyString.c_str());
+   line.str("");
+   line.clear();
+ 
+   //don't count minimization steps as dynamics steps
+   line << "reset_timestep " << ntimestep;
+   MyString = line.str();
+   command(MyString.c_str());
+   line.str("");
+   line.clear(); 
+} 
+
+void Interface_lmp::close_lmp()
+{
+  //closing lammps and MPI
+  delete direct_bonds;
+  delete lmp;
+
+  MPI_Finalize();
+  
+}
@@ -1,40 +1,77 @@
-#include <iostream>
-#include <lammps.h>
-#include <library.h>
-#include <sstream>
-#include <mpi.h>
-#include <cstring>
-
-#ifndef INTERFACE_LMP_H
-#define INTERFACE_LMP_H
-
-using namespace std;
-
-class Interface_lmp
-{
-public:
-   
-    MPI_Comm comm_lammps;
-    LAMMPS_NS::LAMMPS *lmp;
-    int lammps;    
-    int myProc;
-
-    Interface_lmp(int argc, char **argv, bool screen);
-
-    void initiate_lmp(int argc, char **argv, bool screen);
-    void set_timestep(double timestep);
-    void load_bond(int bond_type, int new_id1, int new_id2);
-    void unload_bond(int bond_type, int old_id1, int old_id2);
-    void update_bonds(int bond_type, bool add_link, bool delete_link, int add_link_i, int add_link_j, int delete_link_i, int delete_link_j);
-    void minimize();
-    void run_dynamics(int steps);
-    void print_bonds(int (*extrList)[5], int n_extr_bound);
-    void write_data(string line);
-    void close_lmp();
-
-private:
-    
-    bool isFirstRun;
-};
-
-#endif
+#include <iostream>
+#include <lammps.h>
+#include <library.h>
+#include <sstream>
+#include <mpi.h>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include "bonds_lmp.h"
+
+#ifndef INTERFACE_LMP_H
+#define INTERFACE_LMP_H
+
+using namespace std;
+
+namespace LAMMPS_NS { class Fix; }
+
+class Interface_lmp
+{
+public:
+   
+    MPI_Comm comm_lammps;
+    LAMMPS_NS::LAMMPS *lmp;
+    int lammps;    
+    int myProc;
+    long n_commands; // commands sent to LAMMPS
+
+    Interface_lmp(int argc, char **argv, bool screen, string restart_file = "");
+
+    void initiate_lmp(int argc, char **argv, bool screen, string restart_file);
+    void set_timestep(double timestep);
+    void load_bond(int bond_type, int new_id1, int new_id2);
+    void record_bond(int bond_type, int id1, int id2);
+    void unload_bond(int bond_type, int old_id1, int old_id2);
+    void update_bonds(int bond_type, bool add_link, bool delete_link, int add_link_i, int add_link_j, int delete_link_i, int delete_link_j);
+    void set_direct_bonds(bool direct);
+    int n_pending();
+    void apply_bonds(bool in_run = false);
+    void set_ramp(int bond_type);
+    double new_bond_length();
+    void run_ramped(int steps, int ramp_steps, int stages);
+    void minimize();
+    void run_dynamics(int steps);
+    void run_continuous(LAMMPS_NS::bigint steps, FixExternalFnPtr callback, void *caller);
+    void extruder_positions(const vector<int> &extruders, vector<float> &positions);
+    void print_bonds(const vector<int> &extruders, const vector<float> &positions);
+    void write_data(string line);
+    void write_restart(string fileName);
+    void close_lmp();
+
+private:
+    
+    bool isFirstRun;
+    map<tuple<int,int,int>, int> pending; // (type, id1, id2) -> net bonds to add (+1) or remove (-1)
+    set<tuple<int,int,int> > bonds;       // bonds created through the interface
+    Bonds_lmp *direct_bonds;              // writes bonds in the atom arrays, NULL to use commands
+    LAMMPS_NS::Fix *hook;                 // fix external of the continuous run, NULL outside it
+    int ramp_type;                        // soft type of new bonds before run_ramped, 0 if not used
+    vector<tuple<int,int,int> > ramping;  // new bonds with type ramp_type
+    struct Ramp
+    {
+       double *k;                         // stiffness of each bond type, in the bond style
+       double k_final;                    // stiffness of the extruder bonds
+       LAMMPS_NS::bigint step0;           // timestep at the start of the ramped run
+       int steps, stages;
+    } ramp;                               // stiffness of ramp_type during run_ramped
+
+    void command(const char *line);
+    void end_ramp();
+    static void ramp_stage(void *ptr, LAMMPS_NS::bigint ntimestep, int nlocal, int *, double **, double **fexternal);
+    static tuple<int,int,int> bond_key(int bond_type, int id1, int id2);
+};
+
+#endif
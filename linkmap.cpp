@@ -0,0 +1,230 @@
+#include "linkmap.h"
+#include <algorithm>
+
+#define EMPTY_KEY 0xFFFFFFFFFFFFFFFFULL
+
+/////////////////////////////////////////////
+// LinkMap constructor
+/////////////////////////////////////////////
+LinkMap::LinkMap(int capacity_min)
+{
+   capacity = 16;
+   shift = 60;
+   while (capacity < capacity_min)
+   {
+      capacity *= 2;
+      shift--;
+   }
+
+   keys = new unsigned long long[capacity];
+   counts = new int[capacity];
+   nLinks = 0;
+   for (int s = 0; s < capacity; s++)
+   {
+      keys[s] = EMPTY_KEY;
+      counts[s] = 0;
+   }
+}
+
+LinkMap::~LinkMap()
+{
+   delete[] keys;
+   delete[] counts;
+}
+
+/////////////////////////////////////////////
+// Number of extruders between i and j
+/////////////////////////////////////////////
+int LinkMap::Get(int i, int j)
+{
+   int s = Find(Key(i, j));
+   return (s < 0) ? 0 : counts[s];
+}
+
+/////////////////////////////////////////////
+// Add one extruder between i and j, return the new count
+/////////////////////////////////////////////
+int LinkMap::Increment(int i, int j)
+{
+   unsigned long long key = Key(i, j);
+   int s = Find(key);
+
+   if (s >= 0)
+      return ++counts[s];
+
+   if (2 * (nLinks + 1) > capacity)
+      Grow();
+
+   s = Slot(key);
+   while (keys[s] != EMPTY_KEY)
+      s = (s + 1) & (capacity - 1);
+   keys[s] = key;
+   counts[s] = 1;
+   nLinks++;
+
+   return 1;
+}
+
+/////////////////////////////////////////////
+// Remove one extruder between i and j, return the new count
+// or -1 if there was none
+/////////////////////////////////////////////
+int LinkMap::Decrement(int i, int j)
+{
+   int s = Find(Key(i, j));
+
+   if (s < 0)
+      return -1;
+
+   int n = --counts[s];
+   if (n == 0)
+      Erase(s);
+
+   return n;
+}
+
+/////////////////////////////////////////////
+// Remove all links
+/////////////////////////////////////////////
+void LinkMap::Clear(void)
+{
+   for (int s = 0; s < capacity; s++)
+   {
+      keys[s] = EMPTY_KEY;
+      counts[s] = 0;
+   }
+   nLinks = 0;
+}
+
+/////////////////////////////////////////////
+// Number of distinct (i,j) pairs with at least one extruder
+/////////////////////////////////////////////
+int LinkMap::Size(void)
+{
+   return nLinks;
+}
+
+/////////////////////////////////////////////
+// Existing links with i<j, sorted by i and then j
+/////////////////////////////////////////////
+void LinkMap::List(vector<int> &i, vector<int> &j, vector<int> &n)
+{
+   vector<pair<unsigned long long, int> > entries;
+
+   entries.reserve(nLinks);
+   for (int s = 0; s < capacity; s++)
+      if (keys[s] != EMPTY_KEY)
+         entries.push_back(make_pair(keys[s], counts[s]));
+   sort(entries.begin(), entries.end());
+
+   i.clear();
+   j.clear();
+   n.clear();
+   for (size_t k = 0; k < entries.size(); k++)
+   {
+      i.push_back((int)(entries[k].first >> 32));
+      j.push_back((int)(entries[k].first & 0xFFFFFFFFULL));
+      n.push_back(entries[k].second);
+   }
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+/////////////////////////////////////////////
+// Symmetric key of the pair (i,j)
+/////////////////////////////////////////////
+unsigned long long LinkMap::Key(int i, int j)
+{
+   if (j < i)
+      swap(i, j);
+   return ((unsigned long long)i << 32) | (unsigned long long)(unsigned int)j;
+}
+
+/////////////////////////////////////////////
+// Home slot of a key (Fibonacci hashing)
+/////////////////////////////////////////////
+int LinkMap::Slot(unsigned long long key)
+{
+   return (int)((key * 11400714819323198485ULL) >> shift);
+}
+
+/////////////////////////////////////////////
+// Slot holding key, -1 if absent
+/////////////////////////////////////////////
+int LinkMap::Find(unsigned long long key)
+{
+   int s = Slot(key);
+
+   while (keys[s] != EMPTY_KEY)
+   {
+      if (keys[s] == key)
+         return s;
+      s = (s + 1) & (capacity - 1);
+   }
+
+   return -1;
+}
+
+/////////////////////////////////////////////
+// Double the table and rehash
+/////////////////////////////////////////////
+void LinkMap::Grow(void)
+{
+   unsigned long long *oldKeys = keys;
+   int *oldCounts = counts;
+   int oldCapacity = capacity;
+
+   capacity *= 2;
+   shift--;
+   keys = new unsigned long long[capacity];
+   counts = new int[capacity];
+   for (int s = 0; s < capacity; s++)
+   {
+      keys[s] = EMPTY_KEY;
+      counts[s] = 0;
+   }
+
+   for (int s = 0; s < oldCapacity; s++)
+      if (oldKeys[s] != EMPTY_KEY)
+      {
+         int t = Slot(oldKeys[s]);
+         while (keys[t] != EMPTY_KEY)
+            t = (t + 1) & (capacity - 1);
+         keys[t] = oldKeys[s];
+         counts[t] = oldCounts[s];
+      }
+
+   delete[] oldKeys;
+   delete[] oldCounts;
+}
+
+/////////////////////////////////////////////
+// Free a slot, shifting back the following entries of the probe sequence
+/////////////////////////////////////////////
+void LinkMap::Erase(int slot)
+{
+   int hole = slot;
+   int s = (slot + 1) & (capacity - 1);
+
+   while (keys[s] != EMPTY_KEY)
+   {
+      int home = Slot(keys[s]);
+
+      // move entry s into the hole if its home is not cyclically in (hole, s]
+      if (((s - home) & (capacity - 1)) >= ((s - hole) & (capacity - 1)))
+      {
+         keys[hole] = keys[s];
+         counts[hole] = counts[s];
+         hole = s;
+      }
+      s = (s + 1) & (capacity - 1);
+   }
+
+   keys[hole] = EMPTY_KEY;
+   counts[hole] = 0;
+   nLinks--;
+}
@@ -0,0 +1,41 @@
+#include <vector>
+
+#ifndef LINKMAP_H
+#define LINKMAP_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Sparse symmetric map (i,j) -> number of extruders
+// between sites i and j. Open addressing with linear
+// probing, memory scales with the number of links.
+/////////////////////////////////////////////
+class LinkMap
+{
+
+public:
+  LinkMap(int capacity = 64);
+  ~LinkMap();
+
+  int Get(int i, int j);
+  int Increment(int i, int j);
+  int Decrement(int i, int j);
+  void Clear(void);
+  int Size(void);
+  void List(vector<int> &i, vector<int> &j, vector<int> &n);
+
+private:
+  unsigned long long *keys;
+  int *counts;
+  int capacity; // always a power of 2
+  int shift;
+  int nLinks;
+
+  unsigned long long Key(int i, int j);
+  int Slot(unsigned long long key);
+  int Find(unsigned long long key);
+  void Grow(void);
+  void Erase(int slot);
+};
+
+#endif
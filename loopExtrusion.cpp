@@ -1,95 +1,447 @@
 #include "extrusion.h"
 #include "interface_lmp.h"
+#include "pipeline.h"
+#include "scheduler.h"
+#include "timers.h"
+#include "contacts_lmp.h"
+#include "trajectory.h"
+#include "checkpoint.h"
 #include <sstream>
 #include <iostream>
 #include <string>
+#include <cmath>
 
 #ifndef HPARAMETERS
 #define HPARAMETERS
 #include "parameters.h"
 #endif
 
+/////////////////////////////////////////////
+// State of the kinetics shared with the callback of the continuous run
+/////////////////////////////////////////////
+struct Continuous
+{
+    Parameters *parm;
+    Extrusion *e;
+    Interface_lmp *inter_lmp;
+    LAMMPS_NS::bigint step0;  // timestep at the start of the run
+    double time_next;         // time of the next Gillespie event (HUGE_VAL if none)
+    int iStep;
+    Timers *timers;
+    double callbackTime;      // wall time spent in the callback
+    Contacts_lmp *contacts;   // NULL if no contact map
+    long nSteps;              // timesteps of the run so far
+    long nextBonds;           // timestep of the run from which bond changes are applied again
+    Trajectory *traj;         // open on rank 0 only, if traj_file is given
+};
+
+/////////////////////////////////////////////
+// Gillespie events of all reactions since the start
+/////////////////////////////////////////////
+long CountEvents(Extrusion &e)
+{
+    long n = 0;
+    for (int r=1; r<=NREACT; r++) n += e.n_events[r];
+    return n;
+}
+
+/////////////////////////////////////////////
+// Positions of the extruders, gathered once on all ranks, to the
+// text log and to the frame of the binary trajectory
+/////////////////////////////////////////////
+void WriteExtruders(Parameters &parm, Interface_lmp &inter_lmp, Trajectory &traj, bool logged, bool framed, double time, const vector<int> &extruders, const vector<int64_t> &arrivals)
+{
+    vector<float> positions;
+    if (logged || parm.traj_positions) inter_lmp.extruder_positions(extruders, positions);
+    if (logged) inter_lmp.print_bonds(extruders, positions);
+    if (framed && traj.IsOpen()) traj.Frame(time, extruders, arrivals, positions);
+}
+
+/////////////////////////////////////////////
+// LAMMPS restart file of a checkpoint, in one of two slots
+/////////////////////////////////////////////
+string RestartFile(Parameters &parm, int slot)
+{
+    return parm.checkpoint_file + ".lammps" + to_string(slot);
+}
+
+/////////////////////////////////////////////
+// Checkpoint at the end of segment iStep: the LAMMPS restart goes to the
+// slot not named by the last checkpoint, which stays valid until the
+// kinetics, renamed in place last, name the new one
+/////////////////////////////////////////////
+void WriteCheckpoint(Parameters &parm, Interface_lmp &inter_lmp, Extrusion &e, Window &w, Contacts_lmp *contacts, double time, int iStep, int &slot)
+{
+    inter_lmp.write_restart(RestartFile(parm, slot));
+
+    //contacts up to now, reduced on rank 0
+    if (contacts && !contacts->write(parm.contact_file)) parm.Error(contacts->error);
+
+    if (inter_lmp.myProc == 0)
+    {
+       Checkpoint c;
+       int32_t hasContacts = (contacts != NULL);
+       c.Put(&time, sizeof(double));
+       c.Put(&iStep, sizeof(int));
+       c.Put(&slot, sizeof(int));
+       //with the pipeline the producer is ahead, the kinetics were saved at the end of this window
+       if (parm.pipeline) c.Append(w.state);
+       else e.Save(c);
+       c.Put(&hasContacts, sizeof(int32_t));
+       if (contacts) contacts->save(c);
+       if (!c.Write(parm.checkpoint_file)) parm.Error(c.error);
+    }
+    slot = 1 - slot;
+}
+
+/////////////////////////////////////////////
+// Called by fix external at every timestep of the continuous run:
+// the Gillespie events due by the current time are applied, and their
+// bond changes are sent to LAMMPS at most every bond_stride timesteps
+/////////////////////////////////////////////
+void ContinuousCallback(void *ptr, LAMMPS_NS::bigint ntimestep, int nlocal, int *, double **, double **fexternal)
+{
+    Continuous *c = (Continuous *) ptr;
+    Extrusion &e = *c->e;
+    double time = (ntimestep - c->step0) * c->parm->timestep;
+
+    //no external force, the fix is only used as a hook
+    for (int i=0; i<nlocal; i++) fexternal[i][0] = fexternal[i][1] = fexternal[i][2] = 0.;
+
+    //Contacts every contact_stride timesteps
+    c->nSteps++;
+    if (c->contacts && !(c->nSteps%c->parm->contact_stride))
+    {
+       c->timers->Start(OUTPUT);
+       c->contacts->sample();
+       if (!(c->contacts->n_samples%c->parm->contact_checkpoint) && !c->contacts->write(c->parm->contact_file)) c->parm->Error(c->contacts->error);
+       c->timers->Stop(OUTPUT);
+    }
+
+    bool due = (c->time_next <= time);
+    bool apply = (c->nSteps >= c->nextBonds && c->inter_lmp->n_pending() > 0);
+    if (!due && !apply) return;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    c->timers->Start(GILLESPIE);
+    while (c->time_next <= time)
+    {
+       e.CatchError( e.ApplyEvent( c->parm->debug ) );
+       c->inter_lmp->update_bonds(2, e.add_link, e.delete_link, e.add_link_i, e.add_link_j, e.delete_link_i, e.delete_link_j);
+
+       c->time_next = e.DrawTime( c->parm->debug ) ? c->time_next + e.tau : HUGE_VAL;
+    }
+    c->timers->Stop(GILLESPIE);
+
+    //Apply the net change of links, with one rebuild of the special lists and a reneighboring at the next timestep
+    if (c->nSteps >= c->nextBonds && c->inter_lmp->n_pending() > 0)
+    {
+       c->timers->Start(BONDS);
+       c->inter_lmp->apply_bonds(true);
+       c->timers->Stop(BONDS);
+       c->nextBonds = c->nSteps + c->parm->bond_stride;
+    }
+    if (!due)
+    {
+       c->callbackTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+       return;
+    }
+
+    //Print output
+    c->iStep ++;
+    bool logged = c->parm->stride_log>0 && !(c->iStep%c->parm->stride_log);
+    bool framed = !c->parm->traj_file.empty() && !(c->iStep%c->parm->traj_stride);
+    if (logged || framed)
+    {
+       c->timers->Start(OUTPUT);
+       if (logged)
+       {
+          cout << fixed;
+          cout << "Time = " << time << "\t\t" << "# extruders = " << e.n_extr_bound << endl;
+       }
+       vector<int> extruders;
+       vector<int64_t> arrivals;
+       e.Snapshot(extruders, &arrivals);
+       WriteExtruders(*c->parm, *c->inter_lmp, *c->traj, logged, framed, time, extruders, arrivals);
+       c->timers->Stop(OUTPUT);
+    }
+
+    c->callbackTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
 int main(int argc, char **argv)
 {   
     //Defining variables
     double time=0, tau;
     bool ok;
     int iStep=0;
+    int slot=0; //LAMMPS restart file of the next checkpoint
     double tau_0=0; //minimum time between dynamics runs 
     string data_line = "write_data last.data"; 
     
     //Reading Gillespie parameters
     Parameters parm(argc, argv);
+    if (argc < 3) parm.Error("Name of LAMMPS input file not provided");
+    bool restart = (argc == 4 && string(argv[3]) == "--restart");
+    if (argc > 3 && !restart) parm.Error("Unknown option "+string(argv[3]));
 
     //Initializing extrusion algorithm
     Extrusion e( parm );
 
-    //Reading CTCF sites
-    e.ReadCTCF(parm.ctcf_file);
+    //Resuming from the last checkpoint: time, kinetics and LAMMPS restart file
+    Checkpoint chk;
+    if (restart)
+    {
+       if (parm.checkpoint_file.empty()) parm.Error("--restart needs checkpoint_file in the parameters file");
+       if (!chk.Read(parm.checkpoint_file)) parm.Error(chk.error);
+       if (!chk.Get(&time, sizeof(double)) || !chk.Get(&iStep, sizeof(int)) || !chk.Get(&slot, sizeof(int))) parm.Error(chk.error);
+       if (!e.Restore(chk)) parm.Error(e.exitError);
+       cout << "Restarting from " << parm.checkpoint_file << " at time " << time << " (segment " << iStep << ")" << endl;
+    }
+    else
+    {
+       //Reading CTCF sites
+       e.CatchError( e.ReadCTCF(parm.ctcf_file) );
 
-    //Reading state
-    e.ReadState(parm.state_file, true); 
+       //Reading state
+       e.CatchError( e.ReadState(parm.state_file, true) );
+    }
 
     //Initializing lammps and opening interface
-    Interface_lmp inter_lmp(argc, argv, parm.screen); 
+    Interface_lmp inter_lmp(argc, argv, parm.screen, restart ? RestartFile(parm, slot) : ""); 
+    if (restart) slot = 1 - slot;
     
     //Setting integration timestep
     inter_lmp.set_timestep(parm.timestep);
 
-    //Loading initial extruders in lammps
+    //Choosing how the bonds of the extruders are changed
+    inter_lmp.set_direct_bonds(parm.bond_update == "direct");
+    if (parm.relax == "ramp") inter_lmp.set_ramp(parm.ramp_type);
+
+    //Loading initial extruders in lammps, already in the restart file when resuming
     for (int i=0; i<e.n_extr_bound; i++)
        {
-         inter_lmp.load_bond(2, e.extrList[i][0]+1, e.extrList[i][1]+1);
+         if (restart) inter_lmp.record_bond(2, e.Left(i)+1, e.Right(i)+1);
+         else inter_lmp.load_bond(2, e.Left(i)+1, e.Right(i)+1);
        }
 
+    //Wall time of each phase
+    Timers timers;
+    double wall;
+    if (!parm.timers_file.empty() && inter_lmp.myProc == 0 && !timers.Open(parm.timers_file)) parm.Error("Cannot open file "+parm.timers_file);
+
+    //Contact map of the beads, reduced over the ranks at each checkpoint
+    Contacts_lmp *contacts = NULL;
+    if (!parm.contact_file.empty()) contacts = new Contacts_lmp(inter_lmp.lmp, parm.length, parm.contact_bin, parm.contact_cutoff, parm.contact_format == "full");
+    if (restart)
+    {
+       int32_t hasContacts;
+       if (!chk.Get(&hasContacts, sizeof(int32_t))) parm.Error(chk.error);
+       if (contacts && hasContacts && !contacts->restore(chk)) parm.Error(contacts->error);
+    }
+
+    //Binary trajectory of the extruders, written by rank 0; when resuming, the frames
+    //after the checkpoint go to a file of their own, named after its segment
+    Trajectory traj;
+    string trajFile = restart ? parm.traj_file + "." + to_string(iStep) : parm.traj_file;
+    if (!parm.traj_file.empty() && inter_lmp.myProc == 0 && !traj.Open(trajFile, parm.traj_positions)) parm.Error(traj.error);
+
+    //Extruders at the last log
+    int nBound = e.n_extr_bound;
+    vector<int> logList;
+    vector<int64_t> logArrivals;
+
+    //Single LAMMPS run, the bonds are changed by the callback at the timestep of each event
+    if (parm.run_mode == "continuous")
+    {
+       Continuous c;
+       c.parm = &parm;
+       c.e = &e;
+       c.inter_lmp = &inter_lmp;
+       c.step0 = *(LAMMPS_NS::bigint *) lammps_extract_global(inter_lmp.lmp, "ntimestep");
+       c.iStep = 0;
+       c.timers = &timers;
+       c.callbackTime = 0.;
+       c.contacts = contacts;
+       c.nSteps = 0;
+       c.nextBonds = 0;
+       c.traj = &traj;
+
+       ok = e.DrawTime( parm.debug );
+       if (!ok) cout << "Binding probability is zero, no loop extrusion" << endl;
+       c.time_next = ok ? e.tau : HUGE_VAL;
+
+       wall = MPI_Wtime();
+       inter_lmp.run_continuous((LAMMPS_NS::bigint) llround(parm.time_max/parm.timestep), ContinuousCallback, &c);
+       timers.Add(DYNAMICS, MPI_Wtime() - wall - c.callbackTime);
+
+       //Bond changes of the last events, not sent yet
+       timers.Start(BONDS);
+       inter_lmp.apply_bonds();
+       timers.Stop(BONDS);
+       timers.EndSegment(0, parm.time_max, CountEvents(e), inter_lmp.n_commands);
+       time = parm.time_max;
+       nBound = e.n_extr_bound;
+    }
+
+    //Kinetics of the next windows computed by another thread, ahead of LAMMPS;
+    //the events of each reaction are those of the windows applied so far
+    Pipeline pipe(parm, e);
+    Window w;
+    copy(e.n_events, e.n_events + NREACT + 1, w.n_events);
+    if (parm.run_mode == "segments" && parm.pipeline) pipe.Start(iStep);
+
+    //Length of the windows from the measured costs of LAMMPS
+    Scheduler sched(parm.overhead_target, parm.max_bond_changes, parm.tau_min, parm.timestep);
+
     //Main Gillespie loop    
-    do
+    if (parm.run_mode == "segments") do
     {  
-       while (tau_0 <= parm.tau_min)
+       if (parm.pipeline)
        {
-          // Gillespie event
-          ok = e.Event( parm.debug );
-          
-          if (!ok){
-             cout << "Binding probability is zero, no loop extrusion" << endl;
-             tau_0 = parm.time_max;
-          } 
-          else {
-             tau_0 += e.tau;
-             // Update of links
-             inter_lmp.update_bonds(2, e.add_link, e.delete_link, e.add_link_i, e.add_link_j, e.delete_link_i, e.delete_link_j);
+          //Events computed while LAMMPS was running the previous window
+          timers.Start(GILLESPIE);
+          pipe.Next(w);
+          timers.Stop(GILLESPIE);
+          if (!w.ok) cout << "Binding probability is zero, no loop extrusion" << endl;
+          tau_0 = w.tau;
+          timers.Start(BONDS);
+          for (size_t k=0; k<w.bonds.size(); k+=3)
+             inter_lmp.update_bonds(2, w.bonds[k]>0, w.bonds[k]<0, w.bonds[k+1], w.bonds[k+2], w.bonds[k+1], w.bonds[k+2]);
+          timers.Stop(BONDS);
+          nBound = w.n_extr_bound;
+          logList.swap(w.extruders);
+          logArrivals.swap(w.arrivals);
+       }
+       else
+       {
+          //One timestamp per window, recording the changes of links is part of the gillespie phase
+          timers.Start(GILLESPIE);
+          while (tau_0 <= (parm.schedule ? sched.Next() : parm.tau_min))
+          {
+             // Gillespie event
+             ok = e.Event( parm.debug );
+
+             if (!ok){
+                cout << "Binding probability is zero, no loop extrusion" << endl;
+                tau_0 = parm.time_max;
+             }
+             else {
+                tau_0 += e.tau;
+                // Record the change of links
+                inter_lmp.update_bonds(2, e.add_link, e.delete_link, e.add_link_i, e.add_link_j, e.delete_link_i, e.delete_link_j);
+                if (parm.schedule)
+                {
+                   sched.Event(e.tau);
+                   if (sched.Full(inter_lmp.n_pending())) break;
+                }
+             }
           }
+          timers.Stop(GILLESPIE);
        }
+       if (!parm.pipeline) nBound = e.n_extr_bound;
 
-       //Minimize energy of new configuration
-       inter_lmp.minimize();
+       //Apply the net change of links in one batch
+       wall = MPI_Wtime();
+       timers.Start(BONDS);
+       inter_lmp.apply_bonds();
+       timers.Stop(BONDS);
+
+       //Minimize energy of new configuration, with the ramp only if a new bond is too long
+       timers.Start(MINIMIZE);
+       if (parm.relax == "minimize" || (parm.ramp_max_length > 0. && inter_lmp.new_bond_length() > parm.ramp_max_length))
+          inter_lmp.minimize();
+       timers.Stop(MINIMIZE);
        
        //Molecular dynamics with LAMMPS from time to (time + e.tau)
        int time_left = parm.time_max-time;
+       int steps;
 
        if (ceil(tau_0) > time_left){
-          inter_lmp.run_dynamics(time_left/parm.timestep);
+          steps = time_left/parm.timestep;
           time = parm.time_max;
        }
        else {
-          inter_lmp.run_dynamics(ceil(tau_0)/parm.timestep);      
+          steps = ceil(tau_0)/parm.timestep;
           time += tau_0;
        } 
 
+       int stepsRun = steps;
+       double wallSetup = MPI_Wtime() - wall;
+       wall = MPI_Wtime();
+
+       //The first steps of the run stiffen the new bonds
+       timers.Start(DYNAMICS);
+       if (parm.relax == "ramp") inter_lmp.run_ramped(steps, parm.ramp_steps, parm.ramp_stages);
+       else if (steps > 0) inter_lmp.run_dynamics(steps);
+       timers.Stop(DYNAMICS);
+
+       //Next window from the costs of this one, the same on all ranks
+       if (parm.schedule)
+       {
+          double costs[2] = {wallSetup, MPI_Wtime() - wall};
+          MPI_Bcast(costs, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+          sched.Segment(costs[0], stepsRun, costs[1]);
+       }
+
        //Update internal time variables
        iStep ++;
        tau_0 = 0;
 
+       //Contacts at the end of the segment, every contact_stride segments
+       if (contacts && !(iStep%parm.contact_stride))
+       {
+          timers.Start(OUTPUT);
+          contacts->sample();
+          if (!(contacts->n_samples%parm.contact_checkpoint) && !contacts->write(parm.contact_file)) parm.Error(contacts->error);
+          timers.Stop(OUTPUT);
+       }
+
        //Print output
-       if ( parm.stride_log>0 && !(iStep%parm.stride_log) )
+       bool logged = parm.stride_log>0 && !(iStep%parm.stride_log);
+       bool framed = !parm.traj_file.empty() && !(iStep%parm.traj_stride);
+       if (logged || framed)
        {
-          cout << fixed;
-          cout << "Time = " << time << "\t\t" << "# extruders = " << e.n_extr_bound << endl;
-          inter_lmp.print_bonds(e.extrList, e.n_extr_bound);   
+          timers.Start(OUTPUT);
+          if (logged)
+          {
+             cout << fixed;
+             cout << "Time = " << time << "\t\t" << "# extruders = " << nBound << endl;
+             if (parm.schedule) cout << sched.Report() << endl;
+          }
+          if (!parm.pipeline) e.Snapshot(logList, &logArrivals);
+          WriteExtruders(parm, inter_lmp, traj, logged, framed, time, logList, logArrivals);
+          timers.Stop(OUTPUT);
        }
+
+       //Checkpoint to resume from with --restart, every checkpoint_stride segments
+       if (!parm.checkpoint_file.empty() && !(iStep%parm.checkpoint_stride))
+       {
+          timers.Start(OUTPUT);
+          WriteCheckpoint(parm, inter_lmp, e, w, contacts, time, iStep, slot);
+          timers.Stop(OUTPUT);
+       }
+       timers.EndSegment(iStep, time, parm.pipeline ? w.events : CountEvents(e), inter_lmp.n_commands);
     } while ( time < parm.time_max );
+
+   //The producer may be some windows ahead
+   pipe.Stop();
   
-   cout << "Final number of extruders: " << e.n_extr_bound << endl; 
+   cout << "Final number of extruders: " << nBound << endl; 
+
+   //Contacts since the last checkpoint
+   if (contacts)
+   {
+      if (!contacts->write(parm.contact_file)) parm.Error(contacts->error);
+      cout << "Contact map of " << contacts->n_samples << " samples written to " << parm.contact_file << endl;
+      delete contacts;
+   }
+
+   //Frames still in the buffer and index of the trajectory
+   if (!traj.Close()) parm.Error(traj.error);
+
+   //Where the time went
+   timers.Summary(MPI_COMM_WORLD, parm.pipeline ? w.n_events : e.n_events, e.reaction_name, NREACT, inter_lmp.n_commands);
    
    //Writing final configuration
    inter_lmp.write_data(data_line); 
@@ -1,4 +1,6 @@
 #include "parameters.h"
+#include "textfile.h"
+#include <map>
 
 using namespace std;
 
@@ -9,12 +11,13 @@ Parameters::Parameters( int argc, char **argv )
 {
      string fileName; 
 
-     if ( argc != 3 ) Error("Name of parameters file not provided");
+     if ( argc < 2 ) Error("Name of parameters file not provided");
      fileName = argv[1];
 
      // defaults
      verbose = false;
      length = 0;
+     n_chains = 1;
      k_binding = 0.;
      k_unbinding = 0.;     
      k_step = 0.;  
@@ -27,6 +30,37 @@ Parameters::Parameters( int argc, char **argv )
      tau_min = 0.;
      screen = false;
      debug = false;
+     engine = "direct";
+     bond_update = "commands";
+     run_mode = "segments";
+     bond_stride = 10;
+     pipeline = false;
+     relax = "minimize";
+     ramp_type = 3;
+     ramp_steps = 100;
+     ramp_stages = 10;
+     ramp_max_length = 0.;
+     schedule = false;
+     overhead_target = 0.1;
+     max_bond_changes = 0;
+     timers_file = "";
+     sample_time = -1.;
+     output_prefix = "extrusion1D";
+     n_replicas = 1;
+     n_threads = 0;
+     contact_bin = 0;
+     contact_file = "";
+     contact_cutoff = 1.5;
+     contact_stride = 1;
+     contact_checkpoint = 100;
+     contact_format = "triangle";
+     traj_file = "";
+     traj_stride = 1;
+     traj_positions = false;
+     checkpoint_file = "";
+     checkpoint_stride = 100;
+     replica = 0;
+     rank = 0;
 
      // read file
      ReadFile( fileName );
@@ -38,40 +72,82 @@ Parameters::Parameters( int argc, char **argv )
 /////////////////////////////////////////////
 bool Parameters::ReadFile( string fileName )
 {
-     ifstream fin;
-     string line;
-     vector<string> word;
+     // where the value of each key goes: d=double, i=int, s=string, f=flag without value
+     struct Key { char type; void *value; };
+     map<string, Key> keys = {
+        {"time_max", {'d', &time_max}},
+        {"timestep", {'d', &timestep}},
+        {"stride_log", {'i', &stride_log}},
+        {"k_binding", {'d', &k_binding}},
+        {"k_unbinding", {'d', &k_unbinding}},
+        {"k_step", {'d', &k_step}},
+        {"k_cross_ctcf", {'d', &k_cross_ctcf}},
+        {"verbose", {'f', &verbose}},
+        {"debug", {'f', &debug}},
+        {"screen", {'f', &screen}},
+        {"allow_overcome", {'f', &allow_overcome}},
+        {"n_extr_tot", {'i', &n_extr_tot}},
+        {"seed", {'i', &seed}},
+        {"length", {'i', &length}},
+        {"n_chains", {'i', &n_chains}},
+        {"n_extr_max", {'i', &n_extr_max}},
+        {"tau_min", {'d', &tau_min}},
+        {"ctcf_file", {'s', &ctcf_file}},
+        {"state_file", {'s', &state_file}},
+        {"engine", {'s', &engine}},
+        {"bond_update", {'s', &bond_update}},
+        {"run_mode", {'s', &run_mode}},
+        {"bond_stride", {'i', &bond_stride}},
+        {"pipeline", {'f', &pipeline}},
+        {"relax", {'s', &relax}},
+        {"ramp_type", {'i', &ramp_type}},
+        {"ramp_steps", {'i', &ramp_steps}},
+        {"ramp_stages", {'i', &ramp_stages}},
+        {"ramp_max_length", {'d', &ramp_max_length}},
+        {"schedule", {'f', &schedule}},
+        {"overhead_target", {'d', &overhead_target}},
+        {"max_bond_changes", {'i', &max_bond_changes}},
+        {"timers_file", {'s', &timers_file}},
+        {"sample_time", {'d', &sample_time}},
+        {"output_prefix", {'s', &output_prefix}},
+        {"n_replicas", {'i', &n_replicas}},
+        {"n_threads", {'i', &n_threads}},
+        {"contact_bin", {'i', &contact_bin}},
+        {"contact_file", {'s', &contact_file}},
+        {"contact_cutoff", {'d', &contact_cutoff}},
+        {"contact_stride", {'i', &contact_stride}},
+        {"contact_checkpoint", {'i', &contact_checkpoint}},
+        {"contact_format", {'s', &contact_format}},
+        {"traj_file", {'s', &traj_file}},
+        {"traj_stride", {'i', &traj_stride}},
+        {"traj_positions", {'f', &traj_positions}},
+        {"checkpoint_file", {'s', &checkpoint_file}},
+        {"checkpoint_stride", {'i', &checkpoint_stride}}
+     };
 
+     TextFile fin(" \t\r=");
+     string key;
 
      // open file
-     fin.open(fileName, ios::in);
-     if ( !fin.is_open() ) Error("Cannot open file "+fileName+" for reading parameters");
+     if ( !fin.Open(fileName) ) Error("Cannot open file "+fileName+" for reading parameters");
 
-     // read file
-     while( getline( fin, line ) )
+     // read file, a key and its value on each line, the lines of other words (comments) are skipped
+     while ( !fin.End() )
      {
-        if ( !line.empty() ) 
-        { 
-           Split(line, " \n\t=", word); 
-           if ( word[0] == "time_max" ) time_max = stod( word[1] );
-           if ( word[0] == "timestep" ) timestep = stod( word[1] ); 
-           if ( word[0] == "stride_log" ) stride_log = stoi( word[1] ); 
-           if ( word[0] == "k_binding" ) k_binding = stod( word[1] ); 
-           if ( word[0] == "k_unbinding" ) k_unbinding = stod( word[1] ); 
-           if ( word[0] == "k_step" ) k_step = stod( word[1] ); 
-           if ( word[0] == "k_cross_ctcf" ) k_cross_ctcf = stod( word[1] ); 
-           if ( word[0] == "verbose" ) verbose = true; 
-           if ( word[0] == "debug" ) debug = true;
-           if ( word[0] == "screen" ) screen = true; 
-           if ( word[0] == "allow_overcome" ) allow_overcome = true; 
-           if ( word[0] == "n_extr_tot" ) n_extr_tot = stoi( word[1] ); 
-           if ( word[0] == "seed" ) seed = stoi( word[1] ); 
-           if ( word[0] == "length" ) length = stoi( word[1] ); 
-           if ( word[0] == "n_extr_max" ) n_extr_max = stoi( word[1] ); 
-           if ( word[0] == "tau_min" ) tau_min = stod( word[1] ); 
-           if ( word[0] == "ctcf_file" ) ctcf_file = word[1];
-           if ( word[0] == "state_file" ) state_file = word[1];
-        } 
+        fin.Word( key );
+        map<string, Key>::iterator it = keys.find( key );
+        if ( it != keys.end() )
+        {
+           Key &k = it->second;
+           bool ok = true;
+           if ( k.type == 'f' ) *(bool *) k.value = true;
+           else if ( fin.EndOfLine() ) Error( fin.Where()+": "+key+" needs a value" );
+           else if ( k.type == 'd' ) ok = fin.Double( *(double *) k.value );
+           else if ( k.type == 'i' ) ok = fin.Int( *(int *) k.value );
+           else ok = fin.Word( *(string *) k.value );
+           if ( !ok ) Error( fin.error );
+        }
+        fin.SkipLine();
      }
 
 
@@ -85,6 +161,7 @@ bool Parameters::ReadFile( string fileName )
         cout << "timestep          = "+to_string(timestep) << endl;
         cout << "stride_log        = "+to_string(stride_log) << endl;
         cout << "length            = "+to_string(length) << endl;
+        if ( n_chains > 1 ) cout << "n_chains          = "+to_string(n_chains) << endl;
         cout << "k_binding         = " << k_binding << endl;
         cout << "k_unbinding       = " << k_unbinding << endl;
         cout << "k_step            = " << k_step << endl;
@@ -95,6 +172,47 @@ bool Parameters::ReadFile( string fileName )
         cout << "tau min           = "+to_string(tau_min) << endl;
         cout << "seed              = "+to_string(seed) << endl;
         cout << "debug             = "+BoolToString(debug) << endl;
+        cout << "engine            = "+engine << endl;
+        cout << "bond_update       = "+bond_update << endl;
+        cout << "run_mode          = "+run_mode << endl;
+        if ( run_mode == "continuous" ) cout << "bond_stride       = "+to_string(bond_stride) << endl;
+        cout << "pipeline          = "+BoolToString(pipeline) << endl;
+        cout << "relax             = "+relax << endl;
+        if ( relax == "ramp" )
+        {
+           cout << "ramp_type         = "+to_string(ramp_type) << endl;
+           cout << "ramp_steps        = "+to_string(ramp_steps) << endl;
+           cout << "ramp_stages       = "+to_string(ramp_stages) << endl;
+           cout << "ramp_max_length   = " << ramp_max_length << endl;
+        }
+        cout << "schedule          = "+BoolToString(schedule) << endl;
+        if ( schedule )
+        {
+           cout << "overhead_target   = " << overhead_target << endl;
+           cout << "max_bond_changes  = "+to_string(max_bond_changes) << endl;
+        }
+        cout << "sample_time       = " << sample_time << endl;
+        cout << "n_replicas        = "+to_string(n_replicas) << endl;
+        if ( !timers_file.empty() ) cout << "timers_file       = "+timers_file << endl;
+        if ( !contact_file.empty() )
+        {
+           cout << "contact_file      = "+contact_file << endl;
+           cout << "contact_cutoff    = " << contact_cutoff << endl;
+           cout << "contact_stride    = "+to_string(contact_stride) << endl;
+           cout << "contact_checkpoint= "+to_string(contact_checkpoint) << endl;
+           cout << "contact_format    = "+contact_format << endl;
+        }
+        if ( !traj_file.empty() )
+        {
+           cout << "traj_file         = "+traj_file << endl;
+           cout << "traj_stride       = "+to_string(traj_stride) << endl;
+           cout << "traj_positions    = "+BoolToString(traj_positions) << endl;
+        }
+        if ( !checkpoint_file.empty() )
+        {
+           cout << "checkpoint_file   = "+checkpoint_file << endl;
+           cout << "checkpoint_stride = "+to_string(checkpoint_stride) << endl;
+        }
         if ( !ctcf_file.empty() ) cout << "ctcf_file         "+ctcf_file << endl;
         if ( !state_file.empty() ) cout << "state_file        = "+state_file << endl;        
         cout << endl;
@@ -102,8 +220,27 @@ bool Parameters::ReadFile( string fileName )
 
      // checks
      if (length < 1) Error("The length of the chain mast be larger than 1");
+     if (n_chains < 1 || length % n_chains != 0 || length / n_chains < 2) Error("n_chains must divide length in chains of at least 2 sites");
      if (time_max<1E-15) Error("You must define time_max in the parameter file");
      if (timestep<1E-15) Error("You must define timestep in the parameter file");
+     if (engine != "direct" && engine != "next_reaction") Error("engine must be direct or next_reaction");
+     if (bond_update != "commands" && bond_update != "direct") Error("bond_update must be commands or direct");
+     if (run_mode != "segments" && run_mode != "continuous") Error("run_mode must be segments or continuous");
+     if (run_mode == "continuous" && bond_update != "direct") Error("run_mode continuous needs bond_update direct, commands cannot change bonds inside a run");
+     if (bond_stride < 1) Error("bond_stride must be at least 1");
+     if (relax != "minimize" && relax != "ramp") Error("relax must be minimize or ramp");
+     if (relax == "ramp" && (bond_update != "direct" || run_mode != "segments")) Error("relax ramp needs bond_update direct and run_mode segments");
+     if (relax == "ramp" && (ramp_type < 3 || ramp_steps < 1 || ramp_stages < 1)) Error("ramp_type must be at least 3, ramp_steps and ramp_stages at least 1");
+     if (schedule && (run_mode != "segments" || pipeline)) Error("schedule needs run_mode segments without pipeline");
+     if (schedule && (overhead_target <= 0. || overhead_target >= 1.)) Error("overhead_target must be between 0 and 1");
+     if (sample_time <= 0.) sample_time = time_max / 100.;
+     if (contact_bin < 1) contact_bin = max(1, length / 1000);
+     if (n_replicas < 1) Error("n_replicas must be at least 1");
+     if (contact_cutoff <= 0. || contact_stride < 1 || contact_checkpoint < 1) Error("contact_cutoff must be positive, contact_stride and contact_checkpoint at least 1");
+     if (contact_format != "triangle" && contact_format != "full") Error("contact_format must be triangle or full");
+     if (traj_stride < 1) Error("traj_stride must be at least 1");
+     if (checkpoint_stride < 1) Error("checkpoint_stride must be at least 1");
+     if (!checkpoint_file.empty() && run_mode != "segments") Error("checkpoint_file needs run_mode segments, LAMMPS cannot write a restart inside a run");
 
      // Warnings
      if (time_max <= 2.3/k_binding){
@@ -115,7 +252,7 @@ bool Parameters::ReadFile( string fileName )
         cout << endl;
      }
 
-     fin.close();
+     fin.Close();
 
      return true;
 
@@ -137,34 +274,6 @@ void Parameters::Error( string message )
      exit(1);
 }
 
-/////////////////////////////////////////////
-// Split line into words
-/////////////////////////////////////////////
-void Parameters::Split(const string& s, string c, vector<string>& v) 
-{
-   string::size_type i = 0;
-   string::size_type j = 0;
-   string w;
-
-   v.clear();
-   j = s.find_first_of(c);
-   if ( j ==  string::npos ) { v.push_back(s); return; }
-
-
-   while (j != string::npos) 
-   {
-      v.push_back(s.substr(i, j-i));
-      i = ++j;
-      j = s.find_first_of(c, j);
-
-      if (j == string::npos)
-      {
-         w = s.substr(i, s.length());
-         if ( ! w.empty() ) v.push_back(w);
-      }
-   }
-}
-
 /////////////////////////////////////////////
 // Welcome screen
 /////////////////////////////////////////////
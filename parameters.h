@@ -7,6 +7,7 @@
 #include <ctime>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -21,6 +22,7 @@ class Parameters
       public:
 
       int length;
+      int n_chains;
       double time_max;
       double timestep;
       int stride_log;
@@ -38,6 +40,37 @@ class Parameters
       double tau_min;
       string ctcf_file;
       string state_file;    
+      string engine;
+      string bond_update;
+      string run_mode;
+      int bond_stride;
+      bool pipeline;
+      string relax;
+      int ramp_type;
+      int ramp_steps;
+      int ramp_stages;
+      double ramp_max_length;
+      bool schedule;
+      double overhead_target;
+      int max_bond_changes;
+      string timers_file;
+      double sample_time;
+      string output_prefix;
+      int n_replicas;
+      int n_threads;
+      int contact_bin;
+      string contact_file;
+      double contact_cutoff;
+      int contact_stride;
+      int contact_checkpoint;
+      string contact_format;
+      string traj_file;
+      int traj_stride;
+      bool traj_positions;
+      string checkpoint_file;
+      int checkpoint_stride;
+      int replica;            // random stream of this run, set by the driver
+      int rank;
 
       Parameters( int, char ** );
       void Error( string );
@@ -47,7 +80,6 @@ class Parameters
 
       private:
 
-      void Split(const string& s, string c, vector<string>& v);
       string BoolToString(bool b);
       
 
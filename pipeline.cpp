@@ -0,0 +1,146 @@
+#include "pipeline.h"
+#include <map>
+#include <utility>
+
+/////////////////////////////////////////////
+// Pipeline constructor, e is owned by the producer once started
+/////////////////////////////////////////////
+Pipeline::Pipeline(Parameters &parm_, Extrusion &e_, int capacity_) : parm(parm_), e(e_)
+{
+   capacity = capacity_ < 1 ? 1 : capacity_;
+   ring = new Window[capacity];
+   head = 0;
+   tail = 0;
+   stop = false;
+   first = 0;
+}
+
+Pipeline::~Pipeline()
+{
+   Stop();
+   delete[] ring;
+}
+
+/////////////////////////////////////////////
+// Start producing windows, numbered from first
+/////////////////////////////////////////////
+void Pipeline::Start(long first_)
+{
+   first = first_;
+   producer = thread(&Pipeline::Produce, this);
+}
+
+/////////////////////////////////////////////
+// Next window, waiting for the producer only if it is behind
+/////////////////////////////////////////////
+void Pipeline::Next(Window &w)
+{
+   long h = head.load(memory_order_relaxed);
+
+   if (tail.load(memory_order_acquire) == h)
+   {
+      unique_lock<mutex> lock(waiting);
+      windowReady.wait(lock, [&] { return tail.load(memory_order_acquire) != h; });
+   }
+
+   swap(w, ring[h % capacity]);
+   head.store(h + 1, memory_order_release);
+   Wake(slotFree);
+}
+
+/////////////////////////////////////////////
+// Stop the producer, the windows not taken are lost
+/////////////////////////////////////////////
+void Pipeline::Stop(void)
+{
+   stop = true;
+   Wake(slotFree);
+   if (producer.joinable())
+      producer.join();
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+/////////////////////////////////////////////
+// Wake the other side after a store to head, tail or stop: taking
+// the mutex orders the store before its check of the predicate
+/////////////////////////////////////////////
+void Pipeline::Wake(condition_variable &cv)
+{
+   {
+      lock_guard<mutex> lock(waiting);
+   }
+   cv.notify_one();
+}
+
+void Pipeline::Produce(void)
+{
+   for (long t = 0; ; t++)
+   {
+      // sleep until the driver frees a slot
+      if (t - head.load(memory_order_acquire) == capacity)
+      {
+         unique_lock<mutex> lock(waiting);
+         slotFree.wait(lock, [&] { return t - head.load(memory_order_acquire) < capacity || stop.load(memory_order_relaxed); });
+      }
+      if (stop.load(memory_order_relaxed))
+         return;
+
+      Fill(ring[t % capacity], first + t);
+      tail.store(t + 1, memory_order_release);
+      Wake(windowReady);
+   }
+}
+
+/////////////////////////////////////////////
+// Events of one window, as in the serial loop: at least tau_min long
+/////////////////////////////////////////////
+void Pipeline::Fill(Window &w, long iWindow)
+{
+   map<pair<int, int>, int> net;
+
+   w.tau = 0;
+   w.ok = true;
+   while (w.tau <= parm.tau_min)
+   {
+      if (!e.Event(parm.debug))
+      {
+         w.ok = false;
+         w.tau = parm.time_max;
+         break;
+      }
+
+      w.tau += e.tau;
+      if (e.add_link) net[make_pair(e.add_link_i, e.add_link_j)]++;
+      if (e.delete_link) net[make_pair(e.delete_link_i, e.delete_link_j)]--;
+   }
+
+   w.bonds.clear();
+   for (map<pair<int, int>, int>::iterator it = net.begin(); it != net.end(); ++it)
+      for (int k = 0; k < abs(it->second); k++)
+      {
+         w.bonds.push_back(it->second > 0 ? 1 : -1);
+         w.bonds.push_back(it->first.first);
+         w.bonds.push_back(it->first.second);
+      }
+
+   // the driver logs the window iWindow+1
+   w.n_extr_bound = e.n_extr_bound;
+   w.events = 0;
+   for (int r = 0; r <= NREACT; r++)
+   {
+      w.n_events[r] = e.n_events[r];
+      w.events += (r > 0) ? e.n_events[r] : 0;
+   }
+   w.extruders.clear();
+   w.arrivals.clear();
+   if ((parm.stride_log > 0 && !((iWindow + 1) % parm.stride_log)) || (!parm.traj_file.empty() && !((iWindow + 1) % parm.traj_stride)))
+      e.Snapshot(w.extruders, &w.arrivals);
+   w.state.Clear();
+   if (!parm.checkpoint_file.empty() && !((iWindow + 1) % parm.checkpoint_stride))
+      e.Save(w.state);
+}
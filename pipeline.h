@@ -0,0 +1,70 @@
+#include "extrusion.h"
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef HPARAMETERS
+#define HPARAMETERS
+#include "parameters.h"
+#endif
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Gillespie events between two calls to LAMMPS
+/////////////////////////////////////////////
+struct Window
+{
+  double tau;              // duration of the window
+  bool ok;                 // false if no event could happen
+  vector<int> bonds;       // net bond changes as triplets (+1 add/-1 remove, i, j)
+  int n_extr_bound;        // extruders at the end of the window
+  long events;             // events since the start, at the end of the window
+  long n_events[NREACT + 1]; // events of each reaction since the start, at the end of the window
+  vector<int> extruders;   // extruders at the end of the window as triplets (index, i, j), only when logged
+  vector<int64_t> arrivals; // event counts at the last move of their legs as pairs (i, j), only when logged
+  Checkpoint state;        // kinetics at the end of the window, only when a checkpoint is due
+};
+
+/////////////////////////////////////////////
+// Producer thread running the kinetics ahead of LAMMPS: the
+// windows are passed to the driver through a lock-free
+// single-producer single-consumer ring, a side waiting for the
+// other sleeps on a condition variable instead of spinning
+/////////////////////////////////////////////
+class Pipeline
+{
+
+public:
+  Pipeline(Parameters &parm, Extrusion &e, int capacity = 4);
+  ~Pipeline();
+
+  void Start(long first = 0);
+  void Next(Window &w);
+  void Stop(void);
+
+private:
+  Parameters &parm;
+  Extrusion &e;
+  int capacity;
+  Window *ring;
+  atomic<long> head;   // windows taken by the driver
+  atomic<long> tail;   // windows written by the producer
+  atomic<bool> stop;
+  mutex waiting;                 // only held to sleep and to wake the other side
+  condition_variable slotFree;   // signalled by the driver after taking a window
+  condition_variable windowReady; // signalled by the producer after writing a window
+  thread producer;
+  long first;          // number of the first window, after a restart
+
+  void Wake(condition_variable &cv);
+  void Produce(void);
+  void Fill(Window &w, long iWindow);
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <stdint.h>
+
+#ifndef RNG_H
+#define RNG_H
+
+/////////////////////////////////////////////
+// xoshiro256** random generator (Blackman and Vigna).
+// Each (seed, replica, rank) gets its own stream: the state
+// is jumped ahead by 2^128 steps per replica and by 2^192
+// steps per rank, so streams never overlap.
+/////////////////////////////////////////////
+class Rng
+{
+
+public:
+  uint64_t s[4];
+
+  /////////////////////////////////////////////
+  // Start the stream of (seed, replica, rank)
+  /////////////////////////////////////////////
+  void Seed(uint64_t seed, uint64_t replica = 0, uint64_t rank = 0)
+  {
+    // fill the state with splitmix64
+    uint64_t z = seed;
+    for (int k = 0; k < 4; k++)
+    {
+      z += 0x9E3779B97F4A7C15ULL;
+      uint64_t x = z;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+      s[k] = x ^ (x >> 31);
+    }
+
+    static const uint64_t jump[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                     0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+    static const uint64_t longJump[4] = {0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL,
+                                         0x77710069854EE241ULL, 0x39109BB02ACBE635ULL};
+    for (uint64_t r = 0; r < rank; r++)
+      Jump(longJump);
+    for (uint64_t r = 0; r < replica; r++)
+      Jump(jump);
+  }
+
+  /////////////////////////////////////////////
+  // Next 64 random bits
+  /////////////////////////////////////////////
+  inline uint64_t Next(void)
+  {
+    uint64_t result = Rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = Rotl(s[3], 45);
+
+    return result;
+  }
+
+  /////////////////////////////////////////////
+  // Random double in (0,1)
+  /////////////////////////////////////////////
+  inline double Double(void)
+  {
+    return ((double)(Next() >> 11) + 0.5) * (1. / 9007199254740992.);
+  }
+
+  /////////////////////////////////////////////
+  // Random integer in [0,n), without bias (Lemire)
+  /////////////////////////////////////////////
+  inline int Int(int n)
+  {
+    uint32_t range = (uint32_t)n;
+    uint64_t m = (Next() >> 32) * (uint64_t)range;
+    uint32_t low = (uint32_t)m;
+
+    if (low < range)
+    {
+      uint32_t threshold = (uint32_t)(-range) % range;
+      while (low < threshold)
+      {
+        m = (Next() >> 32) * (uint64_t)range;
+        low = (uint32_t)m;
+      }
+    }
+
+    return (int)(m >> 32);
+  }
+
+private:
+  static inline uint64_t Rotl(uint64_t x, int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  void Jump(const uint64_t *poly)
+  {
+    uint64_t t[4] = {0, 0, 0, 0};
+
+    for (int i = 0; i < 4; i++)
+      for (int b = 0; b < 64; b++)
+      {
+        if (poly[i] & (1ULL << b))
+          for (int k = 0; k < 4; k++)
+            t[k] ^= s[k];
+        Next();
+      }
+
+    for (int k = 0; k < 4; k++)
+      s[k] = t[k];
+  }
+};
+
+#endif
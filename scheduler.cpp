@@ -0,0 +1,103 @@
+#include "scheduler.h"
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+/////////////////////////////////////////////
+// Scheduler constructor, windows last tau_min until costs are measured
+/////////////////////////////////////////////
+Scheduler::Scheduler(double overhead_target, int max_changes, double tau_min, double timestep_)
+{
+   target = overhead_target;
+   maxChanges = max_changes;
+   tauMin = tau_min;
+   timestep = timestep_;
+   tauNext = tau_min;
+   decay = 0.9;
+
+   evCount = evTime = 0.;
+   setup = 0.;
+   sW = sN = sNN = sT = sNT = 0.;
+   runSetup = stepCost = 0.;
+   nSegments = 0;
+}
+
+/////////////////////////////////////////////
+// Duration of the next window
+/////////////////////////////////////////////
+double Scheduler::Next(void)
+{
+   return tauNext;
+}
+
+/////////////////////////////////////////////
+// True if the window has enough net bond changes to be sent to LAMMPS
+/////////////////////////////////////////////
+bool Scheduler::Full(int pending)
+{
+   return maxChanges > 0 && pending >= maxChanges;
+}
+
+/////////////////////////////////////////////
+// Record a Gillespie event of the current window
+/////////////////////////////////////////////
+void Scheduler::Event(double tau)
+{
+   evTime += tau;
+   evCount += 1.;
+}
+
+/////////////////////////////////////////////
+// Record the wall times of the last LAMMPS segment and choose the next window
+/////////////////////////////////////////////
+void Scheduler::Segment(double t_setup, int steps, double t_run)
+{
+   // averages with exponentially decreasing weight of the past
+   setup = nSegments ? decay * setup + (1 - decay) * t_setup : t_setup;
+   evCount *= decay;
+   evTime *= decay;
+
+   // least squares of the run time against the number of steps
+   sW = decay * sW + 1;
+   sN = decay * sN + steps;
+   sNN = decay * sNN + (double)steps * steps;
+   sT = decay * sT + t_run;
+   sNT = decay * sNT + steps * t_run;
+
+   double det = sW * sNN - sN * sN;
+   if (det > 1E-12 * sNN * sW)
+   {
+      stepCost = (sW * sNT - sN * sT) / det;
+      runSetup = (sT - stepCost * sN) / sW;
+   }
+   if (det <= 1E-12 * sNN * sW || stepCost <= 0)
+   {
+      // all segments of the same length: no way to tell setup from integration
+      stepCost = sN > 0 ? sT / sN : 0;
+      runSetup = 0;
+   }
+   runSetup = max(runSetup, 0.);
+   nSegments++;
+
+   // fixed cost / (fixed cost + steps*stepCost) = target
+   double overhead = setup + runSetup;
+   tauNext = tauMin;
+   if (stepCost > 0 && target > 0 && target < 1)
+      tauNext = max(tauMin, overhead * (1 - target) / (target * stepCost) * timestep);
+
+   // with a limit on the bond changes, no longer than needed to reach it at the observed rate
+   if (maxChanges > 0 && evCount > 0 && evTime > 0)
+      tauNext = max(tauMin, min(tauNext, maxChanges * evTime / evCount));
+}
+
+/////////////////////////////////////////////
+// Decision of the scheduler, for the log
+/////////////////////////////////////////////
+string Scheduler::Report(void)
+{
+   ostringstream line;
+   double rate = evTime > 0 ? evCount / evTime : 0;
+
+   line << "Scheduler: event rate = " << rate << ", setup = " << setup + runSetup << " s, step = " << stepCost << " s, next window = " << tauNext;
+   return line.str();
+}
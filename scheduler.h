@@ -0,0 +1,41 @@
+#include <string>
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Chooses the duration of the next window of Gillespie events
+// between two LAMMPS runs, so that the fixed cost of each run
+// (bond changes, minimization, run setup) stays a target
+// fraction of the LAMMPS time
+/////////////////////////////////////////////
+class Scheduler
+{
+
+public:
+  Scheduler(double overhead_target, int max_changes, double tau_min, double timestep);
+
+  double Next(void);
+  bool Full(int pending);
+  void Event(double tau);
+  void Segment(double t_setup, int steps, double t_run);
+  string Report(void);
+
+private:
+  double target;      // target fraction of the LAMMPS time spent in fixed costs
+  int maxChanges;     // net bond changes that end a window, 0 if unlimited
+  double tauMin;      // shortest window
+  double timestep;
+  double tauNext;     // duration of the next window
+  double decay;       // weight of the past segments in the averages
+
+  double evCount, evTime;                  // events and their time, averaged
+  double setup;                            // wall time of bond changes and minimization, averaged
+  double sW, sN, sNN, sT, sNT;             // sums of the fit t_run = runSetup + steps*stepCost
+  double runSetup, stepCost;
+  int nSegments;
+};
+
+#endif
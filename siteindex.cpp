@@ -0,0 +1,189 @@
+#include "siteindex.h"
+
+#define EMPTY_SITE -1
+
+/////////////////////////////////////////////
+// SiteIndex constructor
+/////////////////////////////////////////////
+SiteIndex::SiteIndex(int capacity_min)
+{
+   capacity = 16;
+   shift = 60;
+   while (capacity < capacity_min)
+   {
+      capacity *= 2;
+      shift--;
+   }
+
+   keys = new int[capacity];
+   legs = new Legs[capacity];
+   nSites = 0;
+   for (int k = 0; k < capacity; k++)
+      keys[k] = EMPTY_SITE;
+}
+
+SiteIndex::~SiteIndex()
+{
+   delete[] keys;
+   delete[] legs;
+}
+
+/////////////////////////////////////////////
+// Legs on site s, NULL if there are none
+/////////////////////////////////////////////
+SiteIndex::Legs *SiteIndex::Find(int s)
+{
+   int k = Slot(s);
+
+   while (keys[k] != EMPTY_SITE)
+   {
+      if (keys[k] == s)
+         return &legs[k];
+      k = (k + 1) & (capacity - 1);
+   }
+
+   return NULL;
+}
+
+/////////////////////////////////////////////
+// Legs on site s, a new entry without legs if there were none
+/////////////////////////////////////////////
+SiteIndex::Legs *SiteIndex::Insert(int s)
+{
+   Legs *l = Find(s);
+   if (l != NULL)
+      return l;
+
+   if (2 * (nSites + 1) > capacity)
+      Grow();
+
+   int k = Slot(s);
+   while (keys[k] != EMPTY_SITE)
+      k = (k + 1) & (capacity - 1);
+   keys[k] = s;
+   for (int side = 0; side < 2; side++)
+   {
+      legs[k].head[side] = -1;
+      legs[k].tail[side] = -1;
+   }
+   nSites++;
+
+   return &legs[k];
+}
+
+/////////////////////////////////////////////
+// Remove site s, shifting back the following entries of the probe sequence
+/////////////////////////////////////////////
+void SiteIndex::Erase(int s)
+{
+   Legs *l = Find(s);
+   if (l == NULL)
+      return;
+
+   int hole = l - legs;
+   int k = (hole + 1) & (capacity - 1);
+
+   while (keys[k] != EMPTY_SITE)
+   {
+      int home = Slot(keys[k]);
+
+      // move entry k into the hole if its home is not cyclically in (hole, k]
+      if (((k - home) & (capacity - 1)) >= ((k - hole) & (capacity - 1)))
+      {
+         keys[hole] = keys[k];
+         legs[hole] = legs[k];
+         hole = k;
+      }
+      k = (k + 1) & (capacity - 1);
+   }
+
+   keys[hole] = EMPTY_SITE;
+   nSites--;
+}
+
+/////////////////////////////////////////////
+// Remove all sites
+/////////////////////////////////////////////
+void SiteIndex::Clear(void)
+{
+   for (int k = 0; k < capacity; k++)
+      keys[k] = EMPTY_SITE;
+   nSites = 0;
+}
+
+/////////////////////////////////////////////
+// Occupied sites and their legs, in the order of the table
+/////////////////////////////////////////////
+void SiteIndex::Save(Checkpoint &c)
+{
+   c.Put(&nSites, sizeof(int));
+   for (int k = 0; k < capacity; k++)
+      if (keys[k] != EMPTY_SITE)
+      {
+         c.Put(&keys[k], sizeof(int));
+         c.Put(&legs[k], sizeof(Legs));
+      }
+}
+
+bool SiteIndex::Restore(Checkpoint &c)
+{
+   int n;
+   if (!c.Get(&n, sizeof(int)))
+      return false;
+
+   Clear();
+   for (int k = 0; k < n; k++)
+   {
+      int s;
+      Legs l;
+      if (!c.Get(&s, sizeof(int)) || !c.Get(&l, sizeof(Legs)))
+         return false;
+      *Insert(s) = l;
+   }
+
+   return true;
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+/////////////////////////////////////////////
+// Home slot of a site (Fibonacci hashing)
+/////////////////////////////////////////////
+int SiteIndex::Slot(int s)
+{
+   return (int)(((unsigned long long)(unsigned int)s * 11400714819323198485ULL) >> shift);
+}
+
+/////////////////////////////////////////////
+// Double the table and rehash
+/////////////////////////////////////////////
+void SiteIndex::Grow(void)
+{
+   int *oldKeys = keys;
+   Legs *oldLegs = legs;
+   int oldCapacity = capacity;
+
+   capacity *= 2;
+   shift--;
+   keys = new int[capacity];
+   legs = new Legs[capacity];
+   for (int k = 0; k < capacity; k++)
+      keys[k] = EMPTY_SITE;
+
+   for (int k = 0; k < oldCapacity; k++)
+      if (oldKeys[k] != EMPTY_SITE)
+      {
+         int t = Slot(oldKeys[k]);
+         while (keys[t] != EMPTY_SITE)
+            t = (t + 1) & (capacity - 1);
+         keys[t] = oldKeys[k];
+         legs[t] = oldLegs[k];
+      }
+
+   delete[] oldKeys;
+   delete[] oldLegs;
+}
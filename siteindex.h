@@ -0,0 +1,46 @@
+#include "checkpoint.h"
+
+#ifndef SITEINDEX_H
+#define SITEINDEX_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Sparse map site -> first and last leg of the left (0) and
+// right (1) legs on it, for the occupied sites only. Open
+// addressing with linear probing as LinkMap, memory scales
+// with the number of bound extruders instead of the length.
+/////////////////////////////////////////////
+class SiteIndex
+{
+
+public:
+  struct Legs
+  {
+    int head[2]; // first leg (2*h+side) of each side, sorted by arrival time, -1 if none
+    int tail[2]; // last leg of each side
+  };
+
+  SiteIndex(int capacity = 64);
+  ~SiteIndex();
+
+  Legs *Find(int s);   // NULL if no leg on s; valid until the next Insert or Erase
+  Legs *Insert(int s); // entry of s, created without legs if absent
+  void Erase(int s);
+  void Clear(void);
+  int Size(void) { return nSites; }
+  void Save(Checkpoint &c);
+  bool Restore(Checkpoint &c);
+
+private:
+  int *keys;
+  Legs *legs;
+  int capacity; // always a power of 2
+  int shift;
+  int nSites;
+
+  int Slot(int s);
+  void Grow(void);
+};
+
+#endif
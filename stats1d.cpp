@@ -0,0 +1,92 @@
+#include "stats1d.h"
+
+/////////////////////////////////////////////
+// Stats1D constructor
+/////////////////////////////////////////////
+Stats1D::Stats1D(int length, int bin_size)
+{
+   nSamples = 0;
+   occupancy.assign(length, 0.);
+   loopLength.assign(length, 0);
+   bin = max(bin_size, 1);
+   nBins = (length + bin - 1) / bin;
+   contacts.assign((size_t)nBins * (nBins + 1) / 2, 0);
+}
+
+/////////////////////////////////////////////
+// Add the current extruders of e to the statistics
+/////////////////////////////////////////////
+void Stats1D::Sample(Extrusion &e)
+{
+   for (int w = 0; w < e.n_extr_bound; w++)
+   {
+      int i = e.Left(w);
+      int j = e.Right(w);
+      occupancy[i] += 1.;
+      occupancy[j] += 1.;
+      loopLength[abs(j - i)]++;
+
+      size_t bi = min(i, j) / bin;
+      size_t bj = max(i, j) / bin;
+      contacts[bi * nBins - bi * (bi - 1) / 2 + (bj - bi)]++;
+   }
+   nSamples++;
+}
+
+/////////////////////////////////////////////
+// Add the statistics of another run
+/////////////////////////////////////////////
+void Stats1D::Merge(const Stats1D &other)
+{
+   for (size_t s = 0; s < occupancy.size(); s++)
+   {
+      occupancy[s] += other.occupancy[s];
+      loopLength[s] += other.loopLength[s];
+   }
+   for (size_t k = 0; k < contacts.size(); k++)
+      contacts[k] += other.contacts[k];
+   nSamples += other.nSamples;
+}
+
+/////////////////////////////////////////////
+// Write occupancy profile, loop-length distribution and contact map
+/////////////////////////////////////////////
+bool Stats1D::Write(string prefix)
+{
+   ofstream fout(prefix + "_occupancy.dat");
+   if (!fout.is_open())
+      return false;
+
+   fout << "# site  mean number of extruder legs (" << nSamples << " samples)" << endl;
+   for (size_t s = 0; s < occupancy.size(); s++)
+      fout << s << " " << occupancy[s] / max(nSamples, 1L) << endl;
+   fout.close();
+
+   long nLoops = 0;
+   for (size_t l = 0; l < loopLength.size(); l++)
+      nLoops += loopLength[l];
+
+   fout.open(prefix + "_loops.dat");
+   if (!fout.is_open())
+      return false;
+
+   fout << "# loop length  count  probability (" << nLoops << " loops)" << endl;
+   for (size_t l = 1; l < loopLength.size(); l++)
+      if (loopLength[l] > 0)
+         fout << l << " " << loopLength[l] << " " << (double)loopLength[l] / nLoops << endl;
+   fout.close();
+
+   fout.open(prefix + "_contacts.dat");
+   if (!fout.is_open())
+      return false;
+
+   fout << "# bin_i bin_j  samples with a loop between the bins (" << bin << " sites per bin, " << nSamples << " samples)" << endl;
+   size_t k = 0;
+   for (int bi = 0; bi < nBins; bi++)
+      for (int bj = bi; bj < nBins; bj++, k++)
+         if (contacts[k] > 0)
+            fout << bi << " " << bj << " " << contacts[k] << endl;
+   fout.close();
+
+   return true;
+}
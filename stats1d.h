@@ -0,0 +1,33 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifndef STATS1D_H
+#define STATS1D_H
+
+#include "extrusion.h"
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Loop statistics sampled from the extruders of
+// the 1D engine, without polymer coordinates
+/////////////////////////////////////////////
+class Stats1D
+{
+
+public:
+  long nSamples;
+  vector<double> occupancy;  // sum over samples of the number of legs on each site
+  vector<long> loopLength;   // histogram of j-i over samples and extruders
+  int bin;                   // sites per bin of the contact map
+  int nBins;
+  vector<long> contacts;     // samples with a loop between bins bi<=bj, packed upper triangle
+
+  Stats1D(int length, int bin_size = 1);
+  void Sample(Extrusion &e);
+  void Merge(const Stats1D &other);
+  bool Write(string prefix);
+};
+
+#endif
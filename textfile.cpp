@@ -0,0 +1,268 @@
+#include "textfile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TOKEN_MAX 64 // longest number, copied aside only when not a plain integer
+
+/////////////////////////////////////////////
+// TextFile constructor, tokens separated by the characters of blanks and by newlines
+/////////////////////////////////////////////
+TextFile::TextFile(string blanks)
+{
+   for (int c = 0; c < 256; c++)
+      isBlank[c] = false;
+   for (size_t k = 0; k < blanks.size(); k++)
+      isBlank[(unsigned char)blanks[k]] = true;
+
+   data = NULL;
+   size = 0;
+   pos = 0;
+   line = 1;
+   mapped = false;
+}
+
+TextFile::~TextFile()
+{
+   Close();
+}
+
+/////////////////////////////////////////////
+// Map the file in memory, or read it if it cannot be mapped (e.g. a pipe)
+/////////////////////////////////////////////
+bool TextFile::Open(string fileName_)
+{
+   Close();
+   fileName = fileName_;
+   pos = 0;
+   line = 1;
+
+   int fd = open(fileName.c_str(), O_RDONLY);
+   struct stat st;
+   if (fd < 0 || fstat(fd, &st) != 0)
+   {
+      if (fd >= 0)
+         close(fd);
+      error = "Cannot open file " + fileName;
+      return false;
+   }
+
+   if (S_ISREG(st.st_mode) && st.st_size > 0)
+   {
+      void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED)
+      {
+         madvise(p, st.st_size, MADV_SEQUENTIAL);
+         data = (const char *)p;
+         size = st.st_size;
+         mapped = true;
+      }
+   }
+
+   if (!mapped)
+   {
+      string all;
+      char chunk[1 << 16];
+      ssize_t n;
+      while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+         all.append(chunk, n);
+      char *copy = new char[all.size() + 1];
+      memcpy(copy, all.data(), all.size());
+      data = copy;
+      size = all.size();
+   }
+   close(fd);
+
+   return true;
+}
+
+void TextFile::Close(void)
+{
+   if (mapped)
+      munmap((void *)data, size);
+   else
+      delete[] data;
+   data = NULL;
+   size = 0;
+   mapped = false;
+}
+
+/////////////////////////////////////////////
+// True if the file begins with the n bytes of magic (binary formats)
+/////////////////////////////////////////////
+bool TextFile::Starts(const char *magic, size_t n)
+{
+   return size >= n && memcmp(data, magic, n) == 0;
+}
+
+/////////////////////////////////////////////
+// Skip blanks and newlines, true if nothing is left
+/////////////////////////////////////////////
+bool TextFile::End(void)
+{
+   while (pos < size && (isBlank[(unsigned char)data[pos]] || data[pos] == '\n'))
+   {
+      if (data[pos] == '\n')
+         line++;
+      pos++;
+   }
+
+   return pos == size;
+}
+
+/////////////////////////////////////////////
+// Skip blanks, true if nothing else is left on the line
+/////////////////////////////////////////////
+bool TextFile::EndOfLine(void)
+{
+   while (pos < size && isBlank[(unsigned char)data[pos]])
+      pos++;
+
+   return pos == size || data[pos] == '\n';
+}
+
+/////////////////////////////////////////////
+// Go to the start of the next line
+/////////////////////////////////////////////
+void TextFile::SkipLine(void)
+{
+   const char *nl = (pos < size) ? (const char *)memchr(data + pos, '\n', size - pos) : NULL;
+
+   if (nl == NULL)
+      pos = size;
+   else
+   {
+      pos = nl - data + 1;
+      line++;
+   }
+}
+
+/////////////////////////////////////////////
+// Next token as a string
+/////////////////////////////////////////////
+bool TextFile::Word(string &w)
+{
+   size_t begin, end;
+   if (!Token(begin, end, "a word"))
+      return false;
+
+   w.assign(data + begin, end - begin);
+   return true;
+}
+
+/////////////////////////////////////////////
+// Next token as an integer: digits, or a number with an integer value (1000., 1e6)
+/////////////////////////////////////////////
+bool TextFile::Int(int &v)
+{
+   int64_t v64;
+   if (!Integer(v64, INT32_MIN, INT32_MAX, "an integer"))
+      return false;
+
+   v = (int)v64;
+   return true;
+}
+
+bool TextFile::Int64(int64_t &v)
+{
+   return Integer(v, INT64_MIN, INT64_MAX, "an integer");
+}
+
+/////////////////////////////////////////////
+// Next token as a real number
+/////////////////////////////////////////////
+bool TextFile::Double(double &v)
+{
+   size_t begin, end;
+   if (!Token(begin, end, "a number"))
+      return false;
+
+   char token[TOKEN_MAX + 1], *stop;
+   size_t n = end - begin;
+   if (n <= TOKEN_MAX)
+   {
+      memcpy(token, data + begin, n);
+      token[n] = '\0';
+      v = strtod(token, &stop);
+      if (stop == token + n)
+         return true;
+   }
+
+   return Fail("expected a number, found '" + string(data + begin, n) + "'");
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+// Bounds of the next token, on this or a following line
+bool TextFile::Token(size_t &begin, size_t &end, const char *what)
+{
+   if (End())
+   {
+      error = fileName + ": unexpected end of file, expected " + string(what);
+      return false;
+   }
+
+   begin = pos;
+   while (pos < size && !isBlank[(unsigned char)data[pos]] && data[pos] != '\n')
+      pos++;
+   end = pos;
+
+   return true;
+}
+
+// Plain integers are parsed in place, other forms go through strtod
+bool TextFile::Integer(int64_t &v, int64_t min, int64_t max, const char *what)
+{
+   size_t begin, end;
+   if (!Token(begin, end, what))
+      return false;
+
+   size_t k = begin;
+   bool negative = (data[k] == '-');
+   if (data[k] == '-' || data[k] == '+')
+      k++;
+   if (k < end && end - k <= 18)
+   {
+      int64_t u = 0;
+      while (k < end && data[k] >= '0' && data[k] <= '9')
+         u = 10 * u + (data[k++] - '0');
+      if (k == end)
+      {
+         v = negative ? -u : u;
+         if (v >= min && v <= max)
+            return true;
+         return Fail("integer out of range, found '" + string(data + begin, end - begin) + "'");
+      }
+   }
+
+   char token[TOKEN_MAX + 1], *stop;
+   size_t n = end - begin;
+   if (n <= TOKEN_MAX)
+   {
+      memcpy(token, data + begin, n);
+      token[n] = '\0';
+      double d = strtod(token, &stop);
+      if (stop == token + n && d == floor(d) && d >= (double)min && d <= (double)max)
+      {
+         v = (int64_t)d;
+         return true;
+      }
+   }
+
+   return Fail("expected " + string(what) + ", found '" + string(data + begin, n) + "'");
+}
+
+bool TextFile::Fail(string message)
+{
+   error = Where() + ": " + message;
+   return false;
+}
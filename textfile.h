@@ -0,0 +1,49 @@
+#include <stdint.h>
+#include <string>
+
+#ifndef TEXTFILE_H
+#define TEXTFILE_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Input file mapped in memory and read token by token,
+// without streams nor copies of the lines; the numbers are
+// parsed in place and the errors give the file and line
+/////////////////////////////////////////////
+class TextFile
+{
+
+public:
+  string error;
+
+  TextFile(string blanks = " \t\r");
+  ~TextFile();
+
+  bool Open(string fileName);
+  void Close(void);
+  bool Starts(const char *magic, size_t n);
+  bool End(void);
+  bool EndOfLine(void);
+  void SkipLine(void);
+  bool Word(string &w);
+  bool Int(int &v);
+  bool Int64(int64_t &v);
+  bool Double(double &v);
+  string Where(void) { return fileName + ":" + to_string(line); }
+
+private:
+  string fileName;
+  bool isBlank[256]; // separators of the tokens on a line
+  const char *data;
+  size_t size;
+  size_t pos;      // next byte to read
+  int line;        // line of pos, from 1
+  bool mapped;     // data is mapped, else allocated
+
+  bool Token(size_t &begin, size_t &end, const char *what);
+  bool Integer(int64_t &v, int64_t min, int64_t max, const char *what);
+  bool Fail(string message);
+};
+
+#endif
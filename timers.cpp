@@ -0,0 +1,100 @@
+#include "timers.h"
+#include <iostream>
+#include <iomanip>
+
+static const char *phase_name[N_PHASES] = {"gillespie", "bonds", "minimize", "dynamics", "output"};
+
+/////////////////////////////////////////////
+// Timers constructor, all phases at zero
+/////////////////////////////////////////////
+Timers::Timers()
+{
+   for (int p = 0; p < N_PHASES; p++)
+      segment[p] = total[p] = 0.;
+   lastEvents = lastCommands = 0;
+}
+
+/////////////////////////////////////////////
+// Add time measured elsewhere to a phase of the current segment
+/////////////////////////////////////////////
+void Timers::Add(int phase, double seconds)
+{
+   segment[phase] += seconds;
+}
+
+/////////////////////////////////////////////
+// Open the CSV file with a line per segment
+/////////////////////////////////////////////
+bool Timers::Open(string fileName)
+{
+   csv.open(fileName);
+   if (!csv.is_open())
+      return false;
+
+   csv << "segment,time,events,commands";
+   for (int p = 0; p < N_PHASES; p++)
+      csv << "," << phase_name[p];
+   csv << endl;
+   return true;
+}
+
+/////////////////////////////////////////////
+// Close the current segment, events and commands are totals since the start
+/////////////////////////////////////////////
+void Timers::EndSegment(int iSegment, double time, long events, long commands)
+{
+   if (csv.is_open())
+   {
+      csv << iSegment << "," << time << "," << events - lastEvents << "," << commands - lastCommands;
+      for (int p = 0; p < N_PHASES; p++)
+         csv << "," << segment[p];
+      csv << "\n";
+   }
+
+   for (int p = 0; p < N_PHASES; p++)
+   {
+      total[p] += segment[p];
+      segment[p] = 0.;
+   }
+   lastEvents = events;
+   lastCommands = commands;
+}
+
+/////////////////////////////////////////////
+// Print the time of each phase (min/avg/max over the ranks) and the counters, on rank 0
+/////////////////////////////////////////////
+void Timers::Summary(MPI_Comm comm, long *n_events, string *reaction_names, int n_reactions, long commands)
+{
+   int me, nprocs;
+   double tmin[N_PHASES], tmax[N_PHASES], tsum[N_PHASES];
+
+   MPI_Comm_rank(comm, &me);
+   MPI_Comm_size(comm, &nprocs);
+   MPI_Reduce(total, tmin, N_PHASES, MPI_DOUBLE, MPI_MIN, 0, comm);
+   MPI_Reduce(total, tmax, N_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+   MPI_Reduce(total, tsum, N_PHASES, MPI_DOUBLE, MPI_SUM, 0, comm);
+   if (csv.is_open())
+      csv.close();
+   if (me != 0)
+      return;
+
+   double all = 0.;
+   for (int p = 0; p < N_PHASES; p++)
+      all += tsum[p] / nprocs;
+
+   cout << endl << "Phase        min (s)      avg (s)      max (s)   %avg" << endl;
+   cout << fixed;
+   for (int p = 0; p < N_PHASES; p++)
+      cout << left << setw(10) << phase_name[p] << right << setprecision(3) << setw(11) << tmin[p] << setw(13) << tsum[p] / nprocs << setw(13) << tmax[p] << setprecision(1) << setw(7) << (all > 0 ? 100. * tsum[p] / nprocs / all : 0.) << endl;
+
+   long n = 0;
+   cout << endl;
+   for (int r = 1; r <= n_reactions; r++)
+   {
+      cout << left << setw(16) << reaction_names[r] << right << setw(12) << n_events[r] << endl;
+      n += n_events[r];
+   }
+   cout << left << setw(16) << "All events" << right << setw(12) << n << endl;
+   cout << left << setw(16) << "LAMMPS commands" << right << setw(12) << commands << endl << endl;
+   cout << defaultfloat;
+}
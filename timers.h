@@ -0,0 +1,45 @@
+#include <mpi.h>
+#include <chrono>
+#include <string>
+#include <fstream>
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+using namespace std;
+
+enum Phase { GILLESPIE, BONDS, MINIMIZE, DYNAMICS, OUTPUT, N_PHASES };
+
+/////////////////////////////////////////////
+// Wall time of the phases of the driver, per segment and in
+// total, with a CSV line per segment and a summary over the
+// MPI ranks at the end
+/////////////////////////////////////////////
+class Timers
+{
+
+public:
+  Timers();
+
+  inline void Start(int phase)
+  {
+    start[phase] = chrono::steady_clock::now();
+  }
+  inline void Stop(int phase)
+  {
+    segment[phase] += chrono::duration<double>(chrono::steady_clock::now() - start[phase]).count();
+  }
+  void Add(int phase, double seconds);
+  bool Open(string fileName);
+  void EndSegment(int iSegment, double time, long events, long commands);
+  void Summary(MPI_Comm comm, long *n_events, string *reaction_names, int n_reactions, long commands);
+
+private:
+  chrono::steady_clock::time_point start[N_PHASES];
+  double segment[N_PHASES]; // current segment
+  double total[N_PHASES];
+  long lastEvents, lastCommands;
+  ofstream csv;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "trajectory.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Stop with an error message
+/////////////////////////////////////////////
+void Error(string message)
+{
+    cerr << "ERROR: " << message << endl;
+    exit(1);
+}
+
+/////////////////////////////////////////////
+// Offset of the first frame at time >= t_from and end of the frames,
+// from the index at the end of the file; the first frame and the end
+// of the file if there is no index (the run did not close it), the
+// frames are then read one by one
+/////////////////////////////////////////////
+int64_t FirstFrame(FILE *fp, double t_from, int64_t &end)
+{
+    int64_t first = 16;
+    char magic[8];
+    int64_t tail[2];   // n_frames, offset of the index
+
+    end = INT64_MAX;
+    if (fseeko(fp, -24, SEEK_END) != 0 || fread(tail, sizeof(int64_t), 2, fp) != 2 || fread(magic, 1, 8, fp) != 8) return first;
+    if (memcmp(magic, TRAJ_INDEX_MAGIC, 8) != 0) return first;
+    end = tail[1];
+
+    // binary search on the times of the frames, which never decrease
+    int64_t lo = 0, hi = tail[0];
+    while (lo < hi)
+    {
+       int64_t mid = (lo + hi) / 2;
+       double t;
+       if (fseeko(fp, tail[1] + 16 * mid, SEEK_SET) != 0 || fread(&t, sizeof(double), 1, fp) != 1) Error("Cannot read the index of the frames");
+       if (t < t_from) lo = mid + 1;
+       else hi = mid;
+    }
+    if (lo == tail[0]) return tail[1];
+    if (fseeko(fp, tail[1] + 16 * lo + 8, SEEK_SET) != 0 || fread(&first, sizeof(int64_t), 1, fp) != 1) Error("Cannot read the index of the frames");
+
+    return first;
+}
+
+/////////////////////////////////////////////
+// Binary trajectory of the extruders to the text layout of the log
+// of loopExtrusion, for the frames with t_from <= time <= t_to
+/////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 4) Error("Usage: trajconv file [t_from] [t_to]");
+    double t_from = (argc > 2) ? stod(argv[2]) : -HUGE_VAL;
+    double t_to = (argc > 3) ? stod(argv[3]) : HUGE_VAL;
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == NULL) Error("Cannot open file "+string(argv[1]));
+
+    char magic[8];
+    int32_t flags[2];
+    if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, TRAJ_MAGIC, 8) != 0) Error(string(argv[1])+" is not a trajectory of extruders");
+    if (fread(flags, sizeof(int32_t), 2, fp) != 2) Error("Cannot read the header of "+string(argv[1]));
+    bool positions = flags[0] & TRAJ_POSITIONS;
+
+    int64_t end;
+    if (fseeko(fp, FirstFrame(fp, t_from, end), SEEK_SET) != 0) Error("Cannot read the frames of "+string(argv[1]));
+
+    // frames until t_to, the index or the end of a file left open
+    cout << fixed;
+    double time;
+    int32_t n[2];
+    while (ftello(fp) < end && fread(&time, sizeof(double), 1, fp) == 1 && fread(n, sizeof(int32_t), 2, fp) == 2)
+    {
+       if (time > t_to) break;
+
+       bool shown = (time >= t_from);
+       if (shown) cout << "Time = " << time << "\t\t" << "# extruders = " << n[0] << "\n";
+       for (int k=0; k<n[0]; k++)
+       {
+          int32_t sites[3];
+          int64_t arrivals[2];
+          float x[3];
+          if (fread(sites, sizeof(int32_t), 3, fp) != 3 || fread(arrivals, sizeof(int64_t), 2, fp) != 2 || (positions && fread(x, sizeof(float), 3, fp) != 3))
+          {
+             // without index the run was interrupted, its last frame may be partly written
+             if (end != INT64_MAX) Error("Frame at time "+to_string(time)+" is truncated");
+             cerr << "Frame at time " << time << " is truncated, file not closed by the run" << endl;
+             fclose(fp);
+             return 0;
+          }
+          if (!shown) continue;
+          cout << sites[0] << " " << sites[1]+1 << " " << sites[2]+1;
+          if (positions) cout << " " << x[0] << " " << x[1] << " " << x[2];
+          cout << "\n";
+       }
+    }
+
+    fclose(fp);
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "trajectory.h"
+#include <cstring>
+
+#define TRAJ_BUFFER (1 << 20) // bytes of a buffer handed to the writer
+
+/////////////////////////////////////////////
+// Trajectory constructor, no file open
+/////////////////////////////////////////////
+Trajectory::Trajectory()
+{
+   fp = NULL;
+   positions = false;
+   front = 0;
+   offset = 0;
+   pending = false;
+   stop = false;
+   failed = false;
+}
+
+Trajectory::~Trajectory()
+{
+   Close();
+}
+
+/////////////////////////////////////////////
+// Create the file, write its header and start the writer
+/////////////////////////////////////////////
+bool Trajectory::Open(string fileName, bool positions_)
+{
+   fp = fopen(fileName.c_str(), "wb");
+   if (fp == NULL)
+   {
+      error = "Cannot open file " + fileName;
+      return false;
+   }
+
+   positions = positions_;
+   char magic[8] = TRAJ_MAGIC;
+   int32_t flags[2] = {positions ? TRAJ_POSITIONS : 0, 0};
+   buffer[0].reserve(TRAJ_BUFFER);
+   buffer[1].reserve(TRAJ_BUFFER);
+   Put(magic, 8);
+   Put(flags, sizeof(flags));
+
+   writer = thread(&Trajectory::Write, this);
+
+   return true;
+}
+
+/////////////////////////////////////////////
+// Append a frame: extruders as triplets (index, i, j), arrivals as
+// pairs (i, j) and, if the file has them, positions as triplets (x, y, z)
+/////////////////////////////////////////////
+void Trajectory::Frame(double time, const vector<int> &extruders, const vector<int64_t> &arrivals, const vector<float> &positions_)
+{
+   int32_t n[2] = {(int32_t)(extruders.size() / 3), 0};
+
+   index.push_back(make_pair(time, offset));
+   Put(&time, sizeof(double));
+   Put(n, sizeof(n));
+   for (int k = 0; k < n[0]; k++)
+   {
+      int32_t sites[3] = {extruders[3 * k], extruders[3 * k + 1], extruders[3 * k + 2]};
+      Put(sites, sizeof(sites));
+      Put(&arrivals[2 * k], 2 * sizeof(int64_t));
+      if (positions)
+         Put(&positions_[3 * k], 3 * sizeof(float));
+   }
+
+   if (buffer[front].size() >= TRAJ_BUFFER)
+      Flush();
+}
+
+/////////////////////////////////////////////
+// Write what is left and the index of the frames, then close the file
+/////////////////////////////////////////////
+bool Trajectory::Close(void)
+{
+   if (fp == NULL)
+      return true;
+
+   // the index goes through the writer too, after the last frames
+   int64_t n_frames = index.size(), start = offset;
+   char magic[8] = TRAJ_INDEX_MAGIC;
+   for (size_t f = 0; f < index.size(); f++)
+   {
+      Put(&index[f].first, sizeof(double));
+      Put(&index[f].second, sizeof(int64_t));
+   }
+   Put(&n_frames, sizeof(int64_t));
+   Put(&start, sizeof(int64_t));
+   Put(magic, 8);
+   Flush();
+
+   {
+      unique_lock<mutex> guard(lock);
+      stop = true;
+   }
+   changed.notify_all();
+   writer.join();
+
+   bool ok = !failed && fclose(fp) == 0;
+   fp = NULL;
+   index.clear();
+   if (!ok)
+      error = "Cannot write the trajectory";
+
+   return ok;
+}
+
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+// Private functions
+/////////////////////////////////////////////
+/////////////////////////////////////////////
+
+void Trajectory::Put(const void *data, size_t size)
+{
+   const char *bytes = (const char *)data;
+   buffer[front].insert(buffer[front].end(), bytes, bytes + size);
+   offset += size;
+}
+
+// Hand the front buffer to the writer, once it is done with the other one
+void Trajectory::Flush(void)
+{
+   unique_lock<mutex> guard(lock);
+   changed.wait(guard, [this] { return !pending; });
+   front = 1 - front;
+   pending = true;
+   guard.unlock();
+   changed.notify_all();
+}
+
+// Writer thread: write the back buffer each time one is handed over
+void Trajectory::Write(void)
+{
+   unique_lock<mutex> guard(lock);
+   while (true)
+   {
+      changed.wait(guard, [this] { return pending || stop; });
+      if (!pending)
+         return;
+
+      vector<char> &back = buffer[1 - front];
+      guard.unlock();
+      if (fwrite(back.data(), 1, back.size(), fp) != back.size())
+         failed = true;
+      back.clear();
+      guard.lock();
+
+      pending = false;
+      changed.notify_all();
+   }
+}
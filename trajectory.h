@@ -0,0 +1,63 @@
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+using namespace std;
+
+// layout of the binary trajectory, all values in native byte order:
+//  header  "LETRAJ1\0", int32 flags (TRAJ_POSITIONS), int32 0
+//  frame   double time, int32 n, int32 0, then n records of
+//          int32 index, int32 i, int32 j, int64 arrival of i, int64 arrival of j
+//          [, float x, y, z of the centre of mass with TRAJ_POSITIONS]
+//  index   n_frames entries double time, int64 offset of the frame,
+//          then int64 n_frames, int64 offset of the index, "LEINDEX\0"
+#define TRAJ_MAGIC "LETRAJ1"
+#define TRAJ_INDEX_MAGIC "LEINDEX"
+#define TRAJ_POSITIONS 1
+
+/////////////////////////////////////////////
+// Binary trajectory of the extruders: frames are packed in
+// memory and written by a background thread while the next
+// buffer fills, the index of the frames is written at the end
+/////////////////////////////////////////////
+class Trajectory
+{
+
+public:
+  string error;
+
+  Trajectory();
+  ~Trajectory();
+
+  bool Open(string fileName, bool positions);
+  void Frame(double time, const vector<int> &extruders, const vector<int64_t> &arrivals, const vector<float> &positions);
+  bool Close(void);
+  bool IsOpen(void) { return fp != NULL; }
+
+private:
+  FILE *fp;
+  bool positions;
+  vector<char> buffer[2];   // filled by Frame (front) and being written (back)
+  int front;
+  int64_t offset;           // position in the file of the end of the front buffer
+  vector<pair<double, int64_t> > index;
+  thread writer;
+  mutex lock;
+  condition_variable changed;
+  bool pending;             // the back buffer is waiting to be written
+  bool stop;
+  bool failed;
+
+  void Put(const void *data, size_t size);
+  void Flush(void);
+  void Write(void);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "workpool.h"
+
+/////////////////////////////////////////////
+// WorkPool constructor, n<1 means one thread per core
+/////////////////////////////////////////////
+WorkPool::WorkPool(int n)
+{
+   n_threads = n;
+   if (n_threads < 1)
+      n_threads = thread::hardware_concurrency();
+   if (n_threads < 1)
+      n_threads = 1;
+
+   queues.resize(n_threads);
+   locks = new mutex[n_threads];
+}
+
+WorkPool::~WorkPool()
+{
+   delete[] locks;
+}
+
+/////////////////////////////////////////////
+// Run work(task, thread) for tasks 0..n_tasks-1 and wait for all of them
+/////////////////////////////////////////////
+void WorkPool::Run(int n_tasks, function<void(int task, int thread)> work)
+{
+   vector<thread> workers;
+
+   for (int k = 0; k < n_tasks; k++)
+      queues[k % n_threads].push_back(k);
+
+   for (int t = 0; t < n_threads; t++)
+      workers.push_back(thread([this, t, &work]()
+                               {
+                                  int task;
+                                  while (Take(t, task))
+                                     work(task, t);
+                               }));
+
+   for (int t = 0; t < n_threads; t++)
+      workers[t].join();
+}
+
+/////////////////////////////////////////////
+// Next task of a thread: the last of its own queue,
+// or the first of another queue; false when all are empty
+/////////////////////////////////////////////
+bool WorkPool::Take(int thread, int &task)
+{
+   {
+      lock_guard<mutex> guard(locks[thread]);
+      if (!queues[thread].empty())
+      {
+         task = queues[thread].back();
+         queues[thread].pop_back();
+         return true;
+      }
+   }
+
+   for (int k = 1; k < n_threads; k++)
+   {
+      int victim = (thread + k) % n_threads;
+      lock_guard<mutex> guard(locks[victim]);
+      if (!queues[victim].empty())
+      {
+         task = queues[victim].front();
+         queues[victim].pop_front();
+         return true;
+      }
+   }
+
+   return false;
+}
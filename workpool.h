@@ -0,0 +1,34 @@
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+using namespace std;
+
+/////////////////////////////////////////////
+// Pool of threads running independent tasks: each thread
+// works on its own queue and steals from the others when
+// it is empty
+/////////////////////////////////////////////
+class WorkPool
+{
+
+public:
+  int n_threads;
+
+  WorkPool(int n);
+  ~WorkPool();
+  void Run(int n_tasks, function<void(int task, int thread)> work);
+
+private:
+  vector<deque<int> > queues;
+  mutex *locks;
+
+  bool Take(int thread, int &task);
+};
+
+#endif